@@ -7,6 +7,14 @@
 #include <dirent.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // A complete list of linux system call numbers can be found in: /usr/include/asm/unistd_64.h
 //Defines system call numbers for system calls used in the solution
@@ -20,18 +28,126 @@
 #define RMDIR_SYSCALL 84
 #define MKDIR_SYSCALL 83
 #define TRUNCATE_SYSCALL 76
+#define COPY_FILE_RANGE_SYSCALL 326
+#define IOCTL_SYSCALL 16
+#define LSEEK_SYSCALL 8
+#define FTRUNCATE_SYSCALL 77
+#define FSTAT_SYSCALL 5
+#define MMAP_SYSCALL 9
+#define MUNMAP_SYSCALL 11
+#define FALLOCATE_SYSCALL 285
+#define MADVISE_SYSCALL 28
+#define SPLICE_SYSCALL 275
+#define SENDFILE_SYSCALL 40
+#define PIPE2_SYSCALL 293
+#define FCNTL_SYSCALL 72
+#define IO_URING_SETUP_SYSCALL 425
+#define IO_URING_ENTER_SYSCALL 426
+#define IO_URING_REGISTER_SYSCALL 427
+#define STATX_SYSCALL 332
+#define FADVISE64_SYSCALL 221
+#define SYNC_FILE_RANGE_SYSCALL 277
+#define GETDENTS64_SYSCALL 217
+#define OPENAT_SYSCALL 257
+#define MKDIRAT_SYSCALL 258
+#define NEWFSTATAT_SYSCALL 262
+#define FCHMODAT_SYSCALL 268
+#define UTIMENSAT_SYSCALL 280
+#define PREAD64_SYSCALL 17
+#define PWRITE64_SYSCALL 18
+#define MKNODAT_SYSCALL 259
+#define UNLINKAT_SYSCALL 263
+#define SYMLINKAT_SYSCALL 266
+#define READLINKAT_SYSCALL 267
+
+//Flags of splice and the fcntl command to resize a pipe, in case fcntl.h does not define them
+#ifndef SPLICE_F_MOVE
+#define SPLICE_F_MOVE 1
+#define SPLICE_F_MORE 4
+#endif
+#ifndef F_SETPIPE_SZ
+#define F_SETPIPE_SZ 1031
+#endif
+
+//ioctl request to clone a file, from linux/fs.h (included by linux/io_uring.h)
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
 
 /*Maximum directory name size in linux + length of error message. Used to
 store path argument for files/directories as well as error message if path does
 not exist*/
 #define BUF_SIZE 4145
 
+//Replaces the BLOCK_SIZE of linux/fs.h, which is included by linux/io_uring.h
+#undef BLOCK_SIZE
 #define BLOCK_SIZE 4096
 
+/*Bounds of the buffer used by the read/write engine. The size is picked from
+the block sizes of both files and the size of the source, so small files use a
+small buffer and large files are copied with few large system calls*/
+#define MIN_COPY_BUF_SIZE (128 * 1024)
+#define MAX_COPY_BUF_SIZE (8 * 1024 * 1024)
+
+/*Size of the window of the source mapped at once by the mmap engine (64 MiB).
+Large files are copied by sliding the window along the file*/
+#define MMAP_WINDOW_SIZE (64 * 1024 * 1024)
+
+/*Size of each registered buffer of the io_uring engine, and the default and
+maximum number of buffers read into and written from at once (--queue-depth)*/
+#define URING_BUF_SIZE (256 * 1024)
+#define DEFAULT_QUEUE_DEPTH 8
+#define MAX_QUEUE_DEPTH 64
+
+/*Alignment of offsets, lengths and buffers for O_DIRECT when statx cannot report
+it (STATX_DIOALIGN needs Linux 6.1), and how much data the buffered fallback of
+--direct copies between dropping it from the page cache*/
+#define DIRECT_IO_ALIGN 4096
+#define DROP_CACHE_CHUNK (8 * 1024 * 1024)
+
+/*Size of the buffer files are read through to hash them with --update=checksum,
+and the odd constant words of a file are multiplied by to mix them into its hash*/
+#define HASH_BUF_SIZE (64 * 1024)
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15UL
+
+/*Size of the chunks --delta compares the source and destination in. Only
+chunks that differ are written, so this is the smallest write and matches the
+block size of most filesystems*/
+#define DELTA_CHUNK_SIZE 4096
+
+//Reversed polynomial of CRC32C (Castagnoli), used by --verify and the crc32 instruction of SSE4.2
+#define CRC32C_POLY 0x82F63B78
+
+//Maximum number of worker threads that copy sources at once (-j)
+#define MAX_THREADS 64
+
+/*Size of the buffer each worker reads directory entries into with -r, of the
+blocks paths and names are allocated from, initial number of tasks in each
+worker's deque, and maximum number of files copied by one task. Small batches
+spread the files of a directory over the workers, while each push and pop of a
+task is shared by several files*/
+#define DIRENT_BUF_SIZE (64 * 1024)
+#define ARENA_BLOCK_SIZE (1024 * 1024)
+#define INITIAL_DEQUE_SIZE 64
+#define FILE_BATCH_SIZE 8
+
+//Buffer size used when the size of the source is not known
+#define DEFAULT_COPY_BUF_SIZE (1024 * 1024)
+
+//Size of a memory page, buffers are rounded up to a multiple of this
+#define PAGE_SIZE 4096
+
+/*Maximum number of bytes requested from a single copy_file_range call (1 GiB).
+The kernel may copy less, so calls are repeated until the end of the file*/
+#define CFR_CHUNK_SIZE (1024 * 1024 * 1024)
+
 /*Maximum number of digits used to represent a standard integer is 10. Used to define
 a char[] buffer that is used to store a string representation of an integer*/
 #define MAX_INT_DIGITS 10
 
+//Maximum number of digits of a 64-bit integer, used for byte counts
+#define MAX_LONG_DIGITS 20
+
 /*Defines the number required to convert from an integer representation of a
 number to the ASCII code of that number.*/
 #define ASCII_CONVERSION_INT 48
@@ -46,14 +162,228 @@ number to the ASCII code of that number.*/
 #define WHITE   "\033[39m"
 
 //Defines number of tests to be run by test suite
-#define NUM_TESTS 33
+#define NUM_TESTS 104
 
 //Defines error flags for writeErrorMsg
 #define ERRSTAT -1
 #define ERRREC -2
 #define ERRDIR -3
 #define ERRDEST -4
+#define ERROPT -5
+#define ERRCLONE -6
+#define ERRCOPY -7
+#define ERRDEPTH -8
+#define ERRJOBS -9
+#define ERRMKDIR -10
+#define ERRSELF -11
 #define ERRPERM -13
+#define ERRVERIFY -14
+#define ERROPEN -15
+#define ERRSAME -16
+#define ERRCREATE -17
+
+/*An error flag can carry the errno that caused it, so that its message can say
+why. The errno is stored above the low ERRNO_SHIFT bits of the negated flag, so
+flags with an errno are still negative and never equal to a plain flag*/
+#define ERRNO_SHIFT 8
+
+//Values of --reflink: whether destination is cloned from source on CoW filesystems
+#define REFLINK_NEVER 0
+#define REFLINK_AUTO 1
+#define REFLINK_ALWAYS 2
+
+//Values of --update: how a destination is found to be the same as its source
+#define UPDATE_NONE 0
+#define UPDATE_MTIME 1
+#define UPDATE_CHECKSUM 2
+
+//Values of --engine: how file data is copied when it is not cloned
+#define ENGINE_AUTO 0
+#define ENGINE_RW 1
+#define ENGINE_MMAP 2
+#define ENGINE_CFR 3
+#define ENGINE_SPLICE 4
+#define ENGINE_URING 5
+
+//Options selected on the command line
+struct cpOptions {
+    int reflink;                  //When to clone files with FICLONE instead of copying data
+    bool sparse;                  //Copy only data regions of sparse files, keeping holes
+    bool verbose;                 //Print each file copied and the buffer size chosen
+    int engine;                   //Engine used to copy file data
+    int queueDepth;               //Number of buffers the io_uring engine keeps in flight
+    bool direct;                  //Bypass the page cache with O_DIRECT
+    int numThreads;               //Number of sources, or with -r directories, copied at once
+    bool recursive;               //Copy directories and their contents
+    int update;                   //Skip files whose destination is the same as the source
+    bool delta;                   //Only rewrite the chunks of an existing destination that differ
+    bool verify;                  //Check the checksum of each copy against its source
+};
+
+static struct cpOptions options = { REFLINK_AUTO, false, false, ENGINE_AUTO, DEFAULT_QUEUE_DEPTH, false, 1, false, UPDATE_NONE, false, false };
+
+/*Lookup table of the CRC32C fallback, and whether the CPU has the crc32
+instruction, found once by the first thread to compute a checksum*/
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+static bool crcHardware;
+static unsigned int crcTable[256];
+
+//Number of files and bytes copied and skipped by --update, added to by every worker thread
+struct copyStats {
+    unsigned long filesCopied;
+    unsigned long bytesCopied;
+    unsigned long filesSkipped;
+    unsigned long bytesSkipped;
+};
+
+static struct copyStats stats;
+
+//Serialises error messages printed by the worker threads of -r, which print several parts
+static pthread_mutex_t printLock = PTHREAD_MUTEX_INITIALIZER;
+
+//Whether an error has been printed for any file, so that mycp exits with a failure status
+static bool failed = false;
+
+//Names of engines used in --engine and printed in verbose mode, indexed by engine
+static const char* ENGINE_NAMES[] = { "auto", "rw", "mmap", "cfr", "splice", "uring" };
+
+//Number of engines that can be selected with --engine
+#define NUM_ENGINES 6
+
+//A file being copied and the resources used to copy it, passed to the copy engines
+struct copyFile {
+    int dest;                     //fd of destination file
+    int src;                      //fd of source file
+    char* buf;                    //Page aligned buffer used by the read/write engine, NULL until used
+    size_t bufSize;               //Size of buf
+    bool stream;                  //Whether src is read as a stream (FIFO, device, or a file of unknown size such as in /proc)
+    unsigned int crc;             //CRC32C of the data copied through a user space buffer, with --verify
+    long crcLen;                  //Number of bytes from the start of src that crc covers
+};
+
+//Submission and completion queues shared with the kernel by io_uring
+struct uringQueue {
+    int fd;                       //File descriptor returned by io_uring_setup
+    unsigned int sqEntries;       //Number of entries in the submission queue
+    unsigned int* sqHead;
+    unsigned int* sqTail;
+    unsigned int* sqMask;
+    unsigned int* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int* cqMask;
+    struct io_uring_cqe* cqes;
+    void* sqRing;                 //Mappings of the rings and their sizes, used to unmap them
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+};
+
+//States of a buffer of the io_uring engine
+#define SLOT_IDLE 0
+#define SLOT_READING 1
+#define SLOT_WRITING 2
+
+//A registered buffer of the io_uring engine and the chunk of the file it holds
+struct uringSlot {
+    char* buf;                    //Registered buffer of URING_BUF_SIZE bytes
+    int state;                    //SLOT_IDLE, SLOT_READING or SLOT_WRITING
+    bool inFlight;                //Whether a request for this buffer is in the queue
+    off_t offset;                 //Offset of the chunk in src
+    size_t len;                   //Bytes to read, then bytes read and to write
+    size_t done;                  //Bytes of the current read or write completed
+};
+
+//Sources of main shared by the worker threads that copy them with -j
+struct copyPool {
+    char** sources;               //Source files, in argv order
+    int numSources;
+    char* dest;                   //Destination directory
+    int next;                     //Index of next source to copy, taken atomically by the workers
+    int* results;                 //Error flag of each source, 0 if it was copied
+};
+
+/*A file named relative to an open directory, so that copying the files of a
+directory does not resolve the directory's path again for each file*/
+struct fileRef {
+    int dirfd;                    //Directory name is relative to, or AT_FDCWD
+    char* name;
+    char* path;                   //Path printed in messages
+};
+
+//Directory entry returned by getdents64
+struct linux_dirent64 {
+    unsigned long  d_ino;     /* 64-bit inode number */
+    long           d_off;     /* 64-bit offset to next structure */
+    unsigned short d_reclen;  /* Size of this dirent */
+    unsigned char  d_type;    /* File type */
+    char           d_name[];  /* Filename (null-terminated) */
+};
+
+//Kinds of task in the deques of -r
+#define TASK_DIR 0                //Read a directory, creating its subdirectories and pushing its files
+#define TASK_FILES 1              //Copy a batch of the files of a directory that has been read
+
+/*A directory being copied with -r, opened once and shared by the batches of
+its files. The last task to finish with it gives its copy the permissions of
+the source and closes both directories*/
+struct openDir {
+    int fd;                       //Source directory
+    int destFd;                   //Its copy
+    char* src;                    //Paths of both, printed in messages
+    char* dest;
+    mode_t mode;                  //Permissions of the source directory
+    long refs;                    //Tasks still using the directory
+};
+
+//A task of -r: a directory to copy, or a batch of files in a directory
+struct treeTask {
+    int type;                     //TASK_DIR or TASK_FILES
+    char* src;                    //TASK_DIR: directory to copy and the path of its copy, already created
+    char* dest;
+    struct openDir* dir;          //TASK_FILES: directory the files are in
+    char* names[FILE_BATCH_SIZE]; //TASK_FILES: names of the files
+    int count;
+};
+
+/*Deque of tasks owned by a worker of -r. The owner pushes and pops at the
+bottom, so it walks depth first, while idle workers steal from the top, taking
+the tasks nearest the root which hold the most work*/
+struct dirDeque {
+    struct treeTask* tasks;       //Ring of capacity tasks, mapped with mmap
+    size_t capacity;
+    size_t top;                   //Index of oldest task, taken by thieves
+    size_t bottom;                //Index after newest task, taken by the owner
+    pthread_mutex_t lock;
+};
+
+//Blocks that the paths and names of tasks are allocated from, freed together at the end
+struct pathArena {
+    char* block;                  //Current block, its first bytes point to the previous block
+    size_t used;
+};
+
+//A worker thread of -r, with its deque and path arena
+struct treeWorker {
+    struct treeCopy* tree;
+    int id;
+    struct dirDeque deque;
+    struct pathArena arena;
+};
+
+//Shared state of the workers copying a directory tree with -r
+struct treeCopy {
+    struct treeWorker workers[MAX_THREADS];
+    int numWorkers;
+    long pending;                 //Tasks pushed but not yet finished, 0 when the tree is done
+    pthread_mutex_t lock;         //Held by idle workers while they check for tasks and wait
+    pthread_cond_t wake;          //Signalled when a task is pushed or the tree is done
+    int idle;                     //Number of workers waiting on wake
+    dev_t destDev;                //Device and inode of the destination root, never copied into itself
+    ino_t destIno;
+};
 
 //Headers for system call wrapper functions containing inline assembly
 int myStat(char* fileName, struct stat* meta_data);
@@ -64,14 +394,48 @@ int myCreat(const char* pathname, mode_t mode);
 int myUnlink(const char* pathname);
 int myrmdir(const char* pathname);
 int mymkdir(const char* pathname, mode_t mode);
+int myOpenat(int dirfd, const char* pathname, int flags, mode_t mode);
+int myMkdirat(int dirfd, const char* pathname, mode_t mode);
+int myFstatat(int dirfd, const char* pathname, struct stat* meta_data, int flags);
+int myFchmodat(int dirfd, const char* pathname, mode_t mode);
+int myUtimensat(int dirfd, const char* pathname, const struct timespec times[2], int flags);
+int myMknodat(int dirfd, const char* pathname, mode_t mode, dev_t dev);
+int myUnlinkat(int dirfd, const char* pathname, int flags);
+int mySymlinkat(const char* target, int dirfd, const char* linkpath);
+long myReadlinkat(int dirfd, const char* pathname, char* buf, size_t size);
 int myRead(int fd, void* buf, size_t count);
 int myTruncate(const char* path, off_t length);
+long myCopyFileRange(int fdIn, loff_t* offIn, int fdOut, loff_t* offOut, size_t len, unsigned int flags);
+int myIoctl(int fd, unsigned long request, unsigned long arg);
+off_t myLseek(int fd, off_t offset, int whence);
+int myFstat(int fd, struct stat* meta_data);
+int myFallocate(int fd, int mode, off_t offset, off_t len);
+int myMadvise(void* addr, size_t length, int advice);
+void* myMmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+int myMunmap(void* addr, size_t length);
+int myFtruncate(int fd, off_t length);
+long mySplice(int fdIn, loff_t* offIn, int fdOut, loff_t* offOut, size_t len, unsigned int flags);
+long mySendfile(int outFd, int inFd, off_t* offset, size_t count);
+int myPipe2(int fds[2], int flags);
+int myFcntl(int fd, int cmd, long arg);
+int myIoUringSetup(unsigned int entries, struct io_uring_params* params);
+int myIoUringEnter(long fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags);
+int myIoUringRegister(long fd, unsigned int opcode, void* arg, unsigned int numArgs);
+int myStatx(long dirfd, char* fileName, int flags, unsigned int mask, struct statx* meta_data);
+int myFadvise(int fd, off_t offset, off_t len, int advice);
+int mySyncFileRange(int fd, off_t offset, off_t nbytes, unsigned int flags);
+int myGetDents(long fd, char* buf, unsigned long bufferSize);
+long myPread(int fd, void* buf, size_t count, off_t offset);
+long myPwrite(int fd, const void* buf, size_t count, off_t offset);
 
 //Custom implementations of useful string functions
 int myStrLen(char* str);
 void myStrCpy(char* dest, const char* src, size_t n);
 bool strEqual(char* str1, char* str2);
+bool strPrefix(char* str, char* prefix);
 void myitoa(unsigned int num, char* str);
+void myltoa(unsigned long num, char* str);
+long myatoi(char* str);
 void myPrint(char* str);
 
 //Gets character representing type of file
@@ -80,11 +444,118 @@ void getDirChar(struct stat meta_data, char* dir);
 //Writes error message to stdout if mycp fails
 void writeErrorMsg(char* fileName, int flag);
 
+//Combine an error flag with the errno that caused it, and split them again
+int errorWithErrno(int flag, int err);
+int errorFlag(int error);
+int errorErrno(int error);
+char* errnoMessage(int err);
+void printReason(int err);
+
 //Carries out cp operation
-void mycp(char* dest, char* src);
+int mycp(char* dest, char* src, struct stat* src_meta_data);
+
+//Copies a file named relative to an open directory into another
+int copyAt(struct fileRef* dest, struct fileRef* src, struct stat* src_meta_data);
+
+//Recreates a symlink, FIFO, socket or device found by -r instead of reading it
+int copySpecial(struct fileRef* dest, struct fileRef* src, struct stat* src_meta_data);
+
+//Checks with --update whether a destination is the same as its source, and prints the counts of files copied and skipped
+bool isUnchanged(struct fileRef* dest, struct fileRef* src, struct stat* src_meta_data);
+unsigned long hashFile(int fd, bool* ok);
+void printUpdateStats();
+
+//Checks a source given in argv can be copied and copies it
+int copySource(char* dest, char* src);
+
+//Copies the sources of main with a pool of worker threads, and the function run by each
+int copyParallel(char** sources, int numSources, char* dest, int numThreads, int* results);
+void* copyWorker(void* arg);
+
+/*Copies a directory tree with -r using worker threads that each own a deque of
+directories and batches of files and steal from each other, and the functions
+they use*/
+int copyTree(char* dest, char* src, struct stat* src_meta_data);
+void* treeWorkerRun(void* arg);
+bool tasksAvailable(struct treeCopy* tree);
+void copyDir(struct treeWorker* worker, struct treeTask* task);
+void copyEntry(struct openDir* dir, char* name);
+void releaseDir(struct openDir* dir);
+bool pushDir(struct treeWorker* worker, char* src, char* dest);
+void pushFiles(struct treeWorker* worker, struct treeTask* batch);
+bool pushTask(struct treeWorker* worker, struct treeTask* task);
+bool popTask(struct dirDeque* deque, struct treeTask* task, bool steal);
+char* arenaAlloc(struct pathArena* arena, size_t size);
+void arenaFree(struct pathArena* arena);
+bool joinPath(char* buf, char* dir, char* name);
+char* baseName(char* path);
+void reportError(char* fileName, int flag);
+
+//Parses leading command line options, returns index of first non-option argument
+int parseArgs(int argc, char** argv);
+
+//Makes dest share the data of src on copy-on-write filesystems
+int reflinkFile(int dest, int src);
+
+//Reserves disk space for the destination before copying
+int preallocate(int dest, off_t size);
 
 //Performs operation of writing data to file
-void writeToFile(int dest, int src);
+long writeToFile(struct copyFile* file, long len);
+
+/*Copy engines used by writeToFile. Each copies len bytes from the current
+offset of src to the current offset of dest, or until the end of src if len is
+negative*/
+long copyFileRangeEngine(struct copyFile* file, long len);
+long readWriteEngine(struct copyFile* file, long len);
+long mmapEngine(struct copyFile* file, long len);
+long spliceEngine(struct copyFile* file, long len);
+long drainPipe(struct copyFile* file, int pipeFd, long count);
+long uringEngine(struct copyFile* file, long len);
+long directEngine(struct copyFile* file, long len);
+
+//Buffered copy used by --direct when O_DIRECT cannot be used, dropping data from the page cache
+long dropCacheCopy(struct copyFile* file, long len);
+
+//Finds the O_DIRECT alignment of a file and turns O_DIRECT on or off for an open file
+size_t directAlignment(int fd);
+int setDirect(int fd, bool direct);
+
+//Maps the buffer used by the read/write engines if not already mapped
+int allocCopyBuffer(struct copyFile* file);
+
+//Set up and tear down an io_uring instance used by the io_uring engine
+int uringInit(struct uringQueue* ring, unsigned int entries);
+void uringExit(struct uringQueue* ring);
+void uringDrain(struct uringQueue* ring, int inFlight);
+
+//Copies only the data regions of a sparse file, leaving holes in dest
+long sparseCopy(struct copyFile* file, off_t size);
+
+//Rewrites only the chunks of an existing dest that differ from src, comparing them with SSE2
+long deltaCopy(struct copyFile* file, off_t size);
+bool chunksEqual(const char* a, const char* b, size_t len);
+long readFullAt(int fd, char* buf, size_t count, off_t offset);
+
+/*Computes CRC32C checksums for --verify, with the crc32 instruction of SSE4.2
+if the CPU has it and a lookup table otherwise*/
+unsigned int crc32c(unsigned int crc, const char* buf, size_t len);
+unsigned int crc32cHardware(unsigned int crc, const char* buf, size_t len);
+unsigned int crc32cTable(unsigned int crc, const char* buf, size_t len);
+void crc32cInit();
+void addChecksum(struct copyFile* file, const char* buf, size_t len);
+long checksumFile(struct copyFile* file, int fd, off_t size, unsigned int* crc);
+int verifyCopy(struct copyFile* file, off_t size);
+
+//Sets up and frees the state used to copy a file
+void initCopyFile(struct copyFile* file, int dest, int src, struct stat* src_meta_data);
+void freeCopyFile(struct copyFile* file);
+
+//Picks the size of the read/write buffer from block sizes and the source size
+size_t chooseBufferSize(struct stat* src_meta_data, struct stat* dest_meta_data);
+
+//Writes a whole buffer, retrying partial writes and interrupted calls
+long writeAll(int fd, char* buf, size_t count);
 
 //Functions for unit tests
 int runTests(bool (*testFunctions[]) (), int numTests);
@@ -122,6 +593,85 @@ bool myMkdirTest1();
 bool myMkdirTest2();
 bool myRmdirTest1();
 bool myRmdirTest2();
+bool myCopyFileRangeTest1();
+bool myCopyFileRangeTest2();
+bool writeToFileTest1();
+bool mycpTest1();
+bool myIoctlTest1();
+bool reflinkFileTest1();
+bool parseArgsTest1();
+bool myLseekTest1();
+bool myFtruncateTest1();
+bool writeToFileTest2();
+bool sparseCopyTest1();
+bool myFstatTest1();
+bool myMmapTest1();
+bool readWriteEngineTest1();
+bool writeAllTest1();
+bool chooseBufferSizeTest1();
+bool chooseBufferSizeTest2();
+bool myFallocateTest1();
+bool preallocateTest1();
+bool strPrefixTest1();
+bool myMadviseTest1();
+bool mmapEngineTest1();
+bool parseArgsTest2();
+bool myPipe2Test1();
+bool spliceEngineTest1();
+bool spliceEngineTest2();
+bool mycpTest2();
+bool myatoiTest1();
+bool uringInitTest1();
+bool uringEngineTest1();
+bool parseArgsTest3();
+bool myStatxTest1();
+bool directAlignmentTest1();
+bool directEngineTest1();
+bool directEngineTest2();
+bool copySourceTest1();
+bool copyParallelTest1();
+bool parseArgsTest4();
+bool baseNameTest1();
+bool joinPathTest1();
+bool popTaskTest1();
+bool copyTreeTest1();
+bool copyTreeTest2();
+bool myOpenatTest1();
+bool myMkdiratTest1();
+bool myFstatatTest1();
+bool myFchmodatTest1();
+bool mycpTest3();
+bool myltoaTest1();
+bool myUtimensatTest1();
+bool hashFileTest1();
+bool isUnchangedTest1();
+bool updateTest1();
+bool myPreadTest1();
+bool chunksEqualTest1();
+bool deltaCopyTest1();
+bool deltaCopyTest2();
+bool deltaTest1();
+bool crc32cTest1();
+bool crc32cTest2();
+bool crc32cTableTest1();
+bool verifyCopyTest1();
+bool verifyTest1();
+bool errorWithErrnoTest1();
+bool copyAtTest1();
+bool copyAtTest2();
+bool copyAtTest3();
+bool copyTreeTest3();
+bool spliceEngineTest3();
+bool copyDirTest1();
+bool mycpTest4();
+
+//Copies Source.txt to Dest.txt with an engine and checks the copy is identical
+bool engineCopies(int engine, long fileSize, off_t start, long len);
+
+//Helper functions for tests that copy files
+bool createTestFile(char* fileName, char* contents);
+bool fileContains(char* fileName, char* contents);
+bool createChunkFile(char* fileName, int numChunks, char fill);
 
 /**
 Main function.
@@ -132,44 +682,56 @@ or if no arguments are specified, runs unit tests.
 **/
 int main(int argc, char** argv)
 {
+    //Gets index of first file argument after any options
+    int argIndex = parseArgs(argc, argv);
+    if (argIndex < 0) return ERROPT;
+
+    //Number of file arguments and list of file arguments
+    int numFiles = argc - argIndex;
+    char** files = argv + argIndex;
 
-    if (argc >= 3) {
+    if (numFiles >= 2) {
         //Struct to store meta data of file specified as argument
         struct stat meta_data;
 
         //Checks if final argument is directory for multiple file copying
-        if (argc > 3) {
-            if (!myStat(argv[argc - 1], &meta_data)) {
+        if (numFiles > 2) {
+            if (!myStat(files[numFiles - 1], &meta_data)) {
                 if (!S_ISDIR(meta_data.st_mode)) {
-                    writeErrorMsg(argv[argc - 1], ERRDIR);
+                    writeErrorMsg(files[numFiles - 1], ERRDIR);
                     return ERRDIR;
                 }
             } else {
-                writeErrorMsg(argv[argc - 1], ERRSTAT);
+                writeErrorMsg(files[numFiles - 1], ERRSTAT);
                 return ERRSTAT;
             }
         }
 
-        //Iterates over each file and checks for error, otherwise copies
-        for (int i = 1; i < argc - 1; i++) {
-            int status = myStat(argv[i], &meta_data);
+        /*With -j, copies several sources at once and then reports the error of
+        each in argv order. With -r the threads copy each tree instead*/
+        int numSources = numFiles - 1;
+        size_t resultsSize = numSources * sizeof(int);
+        int* results = MAP_FAILED;
+        if (options.numThreads > 1 && numSources > 1 && !options.recursive) {
+            results = myMmap(NULL, resultsSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
 
-            //If myStat failed write error
-            if (status != 0) {
-                writeErrorMsg(argv[i], ERRSTAT);
-            } else {
-                //Otherwise if file is directory, tell user that -r is not enabled
-                if (S_ISDIR(meta_data.st_mode)) {
-                    writeErrorMsg(argv[i], ERRREC);
-                //Otherwise copy file
-                } else {
-                    mycp(argv[argc - 1], argv[i]);
-                }
+        if (results != MAP_FAILED && copyParallel(files, numSources, files[numFiles - 1], options.numThreads, results) == 0) {
+            for (int i = 0; i < numSources; i++) {
+                if (results[i] != 0) writeErrorMsg(files[i], results[i]);
+            }
+        //Otherwise iterates over each file and checks for error, otherwise copies
+        } else {
+            for (int i = 0; i < numSources; i++) {
+                int status = copySource(files[numFiles - 1], files[i]);
+                if (status != 0) writeErrorMsg(files[i], status);
             }
         }
+        if (results != MAP_FAILED) myMunmap(results, resultsSize);
+        if (options.update != UPDATE_NONE) printUpdateStats();
     //If single file argument, write error to user
-    } else if (argc == 2) {
-        writeErrorMsg(argv[1], ERRDEST);
+    } else if (numFiles == 1) {
+        writeErrorMsg(files[0], ERRDEST);
     //If one argument, run unit tests
     } else if (argc == 1) {
         //Creates list of bool functions to store test functions
@@ -178,460 +740,3465 @@ int main(int argc, char** argv)
         runTests(unitTests, NUM_TESTS);
     }
 
-    return 0;
+    //Exits with a failure status if any file could not be copied
+    return failed ? 1 : 0;
+}
+
+/**
+Parses options given before the file arguments:
+    --reflink=auto    clone files on copy-on-write filesystems, copy data otherwise (default)
+    --reflink=always  clone files, failing if cloning is not supported
+    --reflink=never   always copy data
+    --sparse          copy only the data regions of files, recreating holes in the destination
+    -v                print each file copied and the size of the read/write buffer chosen
+    --engine=<name>   copy data with auto (copy_file_range, or splice for streams), rw, mmap, cfr, splice or uring
+    --queue-depth=<n> number of buffers the uring engine reads into and writes from at once (1 to 64)
+    --direct          bypass the page cache with O_DIRECT, or drop copied data from it if O_DIRECT is unsupported
+    -j <n>            copy up to n sources into the destination directory at once, or with -r n directories (1 to 64)
+    -r                copy directories and their contents
+    --update          skip files whose destination has the same size and modification time
+    --update=checksum skip files whose destination has the same size and contents
+    --delta           only rewrite the chunks of an existing destination that differ
+    --verify          check the CRC32C checksum of each copy against its source
+@argc - number of arguments
+@argv - list of arguments
+@return - index of first non-option argument, -1 if an option is invalid
+**/
+int parseArgs(int argc, char** argv) {
+    int i;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strEqual(argv[i], "--reflink=auto") || strEqual(argv[i], "--reflink")) {
+            options.reflink = REFLINK_AUTO;
+        } else if (strEqual(argv[i], "--reflink=always")) {
+            options.reflink = REFLINK_ALWAYS;
+        } else if (strEqual(argv[i], "--reflink=never")) {
+            options.reflink = REFLINK_NEVER;
+        } else if (strEqual(argv[i], "--sparse")) {
+            options.sparse = true;
+        } else if (strEqual(argv[i], "-v")) {
+            options.verbose = true;
+        } else if (strEqual(argv[i], "--direct")) {
+            options.direct = true;
+        } else if (strEqual(argv[i], "-r") || strEqual(argv[i], "-R")) {
+            options.recursive = true;
+        } else if (strEqual(argv[i], "--update")) {
+            options.update = UPDATE_MTIME;
+        } else if (strEqual(argv[i], "--update=checksum")) {
+            options.update = UPDATE_CHECKSUM;
+        } else if (strEqual(argv[i], "--delta")) {
+            options.delta = true;
+        } else if (strEqual(argv[i], "--verify")) {
+            options.verify = true;
+        } else if (strEqual(argv[i], "-j") && i + 1 < argc) {
+            long threads = myatoi(argv[++i]);
+            if (threads < 1 || threads > MAX_THREADS) {
+                writeErrorMsg(argv[i], ERRJOBS);
+                return -1;
+            }
+            options.numThreads = threads;
+        } else if (strPrefix(argv[i], "--engine=")) {
+            options.engine = -1;
+            for (int engine = 0; engine < NUM_ENGINES; engine++) {
+                if (strEqual(argv[i] + myStrLen("--engine="), (char*) ENGINE_NAMES[engine])) options.engine = engine;
+            }
+            if (options.engine < 0) {
+                writeErrorMsg(argv[i], ERROPT);
+                return -1;
+            }
+        } else if (strPrefix(argv[i], "--queue-depth=")) {
+            long depth = myatoi(argv[i] + myStrLen("--queue-depth="));
+            if (depth < 1 || depth > MAX_QUEUE_DEPTH) {
+                writeErrorMsg(argv[i] + myStrLen("--queue-depth="), ERRDEPTH);
+                return -1;
+            }
+            options.queueDepth = depth;
+        } else {
+            writeErrorMsg(argv[i], ERROPT);
+            return -1;
+        }
+    }
+
+    return i;
 }
 
 /**
-Copies source file to destination file/directory
+Checks that a source given as an argument exists and is not a directory, and
+copies it to the destination
 @dest - destination to copy to
 @src - source to be copied
+@return - 0 if copied, otherwise error flag to pass to writeErrorMsg with src
 **/
-void mycp(char* dest, char* src) {
-    int destFd;
-    struct stat dest_meta_data;
-    struct stat src_meta_data;
-    myStat(dest, &dest_meta_data);
-    myStat(dest, &src_meta_data);
+int copySource(char* dest, char* src) {
+    //Struct to store meta data of file specified as argument
+    struct stat meta_data;
 
-    //If destination is a file
-    if (S_ISREG(dest_meta_data.st_mode)) {
-        //Truncate file to size 0 and open destination for writing
-        myTruncate(dest, 0);
-        destFd = myOpen(dest, O_RDWR);
+    //If myStat failed return error
+    if (myStat(src, &meta_data) != 0) return ERRSTAT;
 
-    //Otherwise if destination is directory
-    } else if (S_ISDIR(dest_meta_data.st_mode)) {
-        //Create path of new file relative to directory path
-        char buf[BUF_SIZE];
-        myStrCpy(buf, dest, myStrLen(dest));
-        myStrCpy(buf + myStrLen(dest), "/", 1);
-        myStrCpy(buf + myStrLen(dest) + 1, src, myStrLen(src));
+    //Otherwise if file is directory, copy it with -r or tell user that -r is not enabled
+    if (S_ISDIR(meta_data.st_mode)) return options.recursive ? copyTree(dest, src, &meta_data) : ERRREC;
 
-        //And create file with name of old file and the same permissions
-        destFd = myCreat(buf, src_meta_data.st_mode);
-    }
+    //Otherwise copy file
+    return mycp(dest, src, &meta_data);
+}
 
-    //Open source file for reading
-    int srcFd = myOpen(src, O_RDONLY);
+/**
+Copies sources into a destination directory with a pool of worker threads.
+Each worker takes the index of the next source from a shared counter and copies
+it, until all sources have been taken. Copying many small files is dominated by
+the latency of opening, creating and closing each one, so copying several at
+once hides most of it. Errors are stored rather than printed, so that the
+caller can report them in argv order.
+@sources - sources to copy
+@numSources - number of sources
+@dest - destination directory
+@numThreads - number of workers, including the calling thread
+@results - filled with the error flag of each source, 0 if it was copied
+@return - 0 if successful, error number if no worker thread could be created
+**/
+int copyParallel(char** sources, int numSources, char* dest, int numThreads, int* results) {
+    pthread_t threads[MAX_THREADS];
+    struct copyPool pool = { sources, numSources, dest, 0, results };
+    int started = 0;
 
-    if (srcFd < 0) writeErrorMsg(src, srcFd);
+    //The calling thread is also a worker, so one fewer thread is created
+    if (numThreads > numSources) numThreads = numSources;
+    for (int i = 0; i < numThreads - 1; i++) {
+        if (pthread_create(&threads[started], NULL, copyWorker, &pool) != 0) break;
+        started++;
+    }
 
-    //Write data from source file to destination file if any
-    if (src_meta_data.st_size > 0) writeToFile(destFd, srcFd);
+    //Falls back to copying one source at a time without any workers
+    if (started == 0 && numThreads > 1) return EAGAIN;
 
-    myClose(destFd);
-    myClose(srcFd);
+    copyWorker(&pool);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    return 0;
 }
 
 /**
-Writes data from src to dest
-@dest - fd of destination file
-@src - fd of source file
+Worker thread that copies sources of a copyPool until none are left
+@arg - copyPool shared by the workers
+@return - NULL
 **/
-void writeToFile(int dest, int src) {
-    int bytesRead;
-    char buf[BLOCK_SIZE];
-    while ((bytesRead = myRead(src, buf, BLOCK_SIZE)) != 0) myWrite(dest, buf, bytesRead);
-}
+void* copyWorker(void* arg) {
+    struct copyPool* pool = arg;
+    int i;
 
+    while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->numSources) {
+        pool->results[i] = copySource(pool->dest, pool->sources[i]);
+    }
 
+    return NULL;
+}
 
 /**
-Custom wrapper function for stat system call using inline assembly
-@fileName - name of file to get meta data about
-@meta_data - struct to store file meta data in
-@return - status code
+Copies a directory tree for -r. The copy of src is dest if dest does not exist,
+otherwise a directory named after src inside dest. The tree is copied by
+options.numThreads workers, which each own a deque of tasks. A worker reads a
+directory with getdents64, creates its subdirectories with mkdir and pushes
+them onto its own deque, along with batches of the other entries, so the files
+of even a single flat directory are copied by every worker. When its deque is
+empty a worker steals from the other workers, and sleeps until more tasks are
+pushed if there are none. Errors in the tree are printed as they happen.
+@dest - destination to copy to
+@src - directory to copy
+@src_meta_data - meta data of src
+@return - 0 if the tree was walked, otherwise error flag to pass to
+writeErrorMsg with src
 **/
-int myStat(char* fileName, struct stat* meta_data) {
-    long ret = -1;
+int copyTree(char* dest, char* src, struct stat* src_meta_data) {
+    struct treeCopy tree;
+    struct stat dest_meta_data;
+    char root[BUF_SIZE];
+    pthread_t threads[MAX_THREADS];
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)STAT_SYSCALL), "r"(fileName), "r"(meta_data) :
-         "%rax","%rdi", "%rsi","memory" );
+    //Copies into a directory named after src if dest is an existing directory
+    if (myStat(dest, &dest_meta_data) == 0 && S_ISDIR(dest_meta_data.st_mode)) {
+        if (!joinPath(root, dest, baseName(src))) return ERRMKDIR;
+    } else {
+        if (myStrLen(dest) >= BUF_SIZE) return ERRMKDIR;
+        myStrCpy(root, dest, myStrLen(dest));
+    }
 
-    return ret;
+    /*Creates the root of the copy, writable so the copy can be filled in. The
+    root is remembered so that copying a directory into itself stops there*/
+    int status = mymkdir(root, src_meta_data->st_mode | S_IRWXU);
+    if ((status != 0 && status != -EEXIST) || myStat(root, &dest_meta_data) != 0 || !S_ISDIR(dest_meta_data.st_mode)) {
+        reportError(root, (status != 0 && status != -EEXIST) ? errorWithErrno(ERRMKDIR, -status) : ERRMKDIR);
+        return 0;
+    }
+    tree.destDev = dest_meta_data.st_dev;
+    tree.destIno = dest_meta_data.st_ino;
+    if (dest_meta_data.st_dev == src_meta_data->st_dev && dest_meta_data.st_ino == src_meta_data->st_ino) return ERRSELF;
+
+    tree.numWorkers = options.numThreads;
+    tree.pending = 0;
+    tree.idle = 0;
+    pthread_mutex_init(&tree.lock, NULL);
+    pthread_cond_init(&tree.wake, NULL);
+    for (int i = 0; i < tree.numWorkers; i++) {
+        struct treeWorker* worker = &tree.workers[i];
+        worker->tree = &tree;
+        worker->id = i;
+        worker->deque.tasks = NULL;
+        worker->deque.capacity = 0;
+        worker->deque.top = 0;
+        worker->deque.bottom = 0;
+        pthread_mutex_init(&worker->deque.lock, NULL);
+        worker->arena.block = NULL;
+        worker->arena.used = 0;
+    }
+
+    //Seeds the first worker with the root, the others start by stealing
+    if (pushDir(&tree.workers[0], src, root)) {
+        //The calling thread is the first worker
+        int started = 1;
+        while (started < tree.numWorkers && pthread_create(&threads[started], NULL, treeWorkerRun, &tree.workers[started]) == 0) {
+            started++;
+        }
+        treeWorkerRun(&tree.workers[0]);
+        for (int i = 1; i < started; i++) pthread_join(threads[i], NULL);
+    } else {
+        status = ERRCOPY;
+    }
+
+    for (int i = 0; i < tree.numWorkers; i++) {
+        struct dirDeque* deque = &tree.workers[i].deque;
+        if (deque->tasks != NULL) myMunmap(deque->tasks, deque->capacity * sizeof(struct treeTask));
+        pthread_mutex_destroy(&deque->lock);
+        arenaFree(&tree.workers[i].arena);
+    }
+    pthread_cond_destroy(&tree.wake);
+    pthread_mutex_destroy(&tree.lock);
+
+    return (status == ERRCOPY) ? ERRCOPY : 0;
 }
 
 /**
-Custom wrapper function for open system call using inline assembly
-@fileName - name of file to open
-@mode - access mode of file
-@return - file descriptor if successful, -1 if error occurred
+Worker thread of copyTree. Runs tasks from its own deque, newest first, and
+steals the oldest task of another worker when its deque is empty. If no worker
+has a task it sleeps until one is pushed, and finishes once every task pushed
+has been finished.
+@arg - treeWorker to run
+@return - NULL
 **/
-int myOpen(char* fileName, mode_t mode) {
-    long ret = -1;
+void* treeWorkerRun(void* arg) {
+    struct treeWorker* worker = arg;
+    struct treeCopy* tree = worker->tree;
+    struct treeTask task;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)OPEN_SYSCALL), "r"(fileName), "r"((long)mode) :
-         "%rax","%rdi", "%rsi","memory" );
+    while (true) {
+        bool found = popTask(&worker->deque, &task, false);
 
-    return ret;
+        //Tries to steal from the other workers, starting after this one
+        for (int i = 1; !found && i < tree->numWorkers; i++) {
+            found = popTask(&tree->workers[(worker->id + i) % tree->numWorkers].deque, &task, true);
+        }
+
+        if (found) {
+            if (task.type == TASK_DIR) {
+                copyDir(worker, &task);
+            } else {
+                for (int i = 0; i < task.count; i++) copyEntry(task.dir, task.names[i]);
+                releaseDir(task.dir);
+            }
+
+            //Wakes the idle workers to finish once the last task is done
+            if (__atomic_sub_fetch(&tree->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+                pthread_mutex_lock(&tree->lock);
+                pthread_cond_broadcast(&tree->wake);
+                pthread_mutex_unlock(&tree->lock);
+            }
+            continue;
+        }
+
+        /*Another worker is running a task that may push more, so waits for it.
+        Tasks are checked for while holding the lock pushers signal under, so
+        a push cannot be missed between the check and the wait*/
+        pthread_mutex_lock(&tree->lock);
+        tree->idle++;
+        while (__atomic_load_n(&tree->pending, __ATOMIC_ACQUIRE) > 0 && !tasksAvailable(tree)) {
+            pthread_cond_wait(&tree->wake, &tree->lock);
+        }
+        tree->idle--;
+        bool done = (__atomic_load_n(&tree->pending, __ATOMIC_ACQUIRE) == 0);
+        pthread_mutex_unlock(&tree->lock);
+
+        if (done) break;
+    }
+
+    return NULL;
 }
 
 /**
-Custom wrapper function for close system call using inline assembly
-@fd - file descriptor of file to close
-@return - 0 if successful, -1 if error and errno is set
+Checks whether any worker's deque holds a task
+@tree - tree being copied
+@return - whether a task can be taken
 **/
-int myClose(long fd) {
-    long ret = -1;
+bool tasksAvailable(struct treeCopy* tree) {
+    bool available = false;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)CLOSE_SYSCALL), "r"(fd) :
-         "%rax","%rdi","memory" );
+    for (int i = 0; i < tree->numWorkers && !available; i++) {
+        struct dirDeque* deque = &tree->workers[i].deque;
+        pthread_mutex_lock(&deque->lock);
+        available = (deque->bottom > deque->top);
+        pthread_mutex_unlock(&deque->lock);
+    }
 
-    return ret;
+    return available;
 }
 
 /**
-Custom wrapper function for write system call using inline assembly
-@fd - stream to write to
-@buf - to write from
-@count - size to write
+Reads a directory into its copy, which has already been created. Both
+directories are opened once, and their entries are then named relative to
+them, so paths are only resolved once per directory rather than once per file.
+Subdirectories are created and pushed onto the worker's deque. The other
+entries are pushed in batches of up to FILE_BATCH_SIZE, to be copied by this
+or another worker with copyEntry. The copy is given the permissions of the
+directory once the last of its batches has been copied.
+@worker - worker copying the directory
+@task - directory and the path of its copy
 **/
-int myWrite(int fd, const void* buf, size_t count) {
-    long ret = -1;
+void copyDir(struct treeWorker* worker, struct treeTask* task) {
+    char direntBuf[DIRENT_BUF_SIZE];
+    char srcPath[BUF_SIZE];
+    char destPath[BUF_SIZE];
+    struct stat meta_data;
+    struct stat dir_meta_data;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "movq %4, %%rdx\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)WRITE_SYSCALL),"r"((long)fd), "r"(buf), "r"(count) :
-         "%rax","%rdi","%rsi","%rdx","memory" );
+    int fd = myOpenat(AT_FDCWD, task->src, O_RDONLY | O_DIRECTORY, 0);
+    if (fd < 0) {
+        reportError(task->src, errorWithErrno(ERROPEN, -fd));
+        return;
+    }
+    int destFd = myOpenat(AT_FDCWD, task->dest, O_RDONLY | O_DIRECTORY, 0);
+    struct openDir* dir = (struct openDir*) arenaAlloc(&worker->arena, sizeof(struct openDir));
+    if (destFd < 0 || dir == NULL || myFstat(fd, &dir_meta_data) != 0) {
+        reportError(task->dest, (destFd < 0) ? errorWithErrno(ERRMKDIR, -destFd) : ERRMKDIR);
+        if (destFd >= 0) myClose(destFd);
+        myClose(fd);
+        return;
+    }
 
-    return ret;
+    //Holds a reference while reading, so the directory is not finished by a batch before then
+    dir->fd = fd;
+    dir->destFd = destFd;
+    dir->src = task->src;
+    dir->dest = task->dest;
+    dir->mode = dir_meta_data.st_mode;
+    dir->refs = 1;
+
+    struct treeTask batch;
+    batch.type = TASK_FILES;
+    batch.dir = dir;
+    batch.count = 0;
+
+    int bytesRead;
+    while ((bytesRead = myGetDents(fd, direntBuf, DIRENT_BUF_SIZE)) > 0) {
+        struct linux_dirent64* d;
+        for (int bpos = 0; bpos < bytesRead; bpos += d->d_reclen) {
+            d = (struct linux_dirent64*) (direntBuf + bpos);
+            if (strEqual(d->d_name, ".") || strEqual(d->d_name, "..")) continue;
+
+            /*Only directories are stat'd here, the other entries are stat'd as
+            they are copied. Entries are not followed through symlinks, so that
+            the walk cannot loop through a link to a directory. Filesystems
+            that do not report d_type are stat'd to find it*/
+            bool isDir = (d->d_type == DT_DIR || d->d_type == DT_UNKNOWN)
+                && myFstatat(fd, d->d_name, &meta_data, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(meta_data.st_mode);
+
+            if (!isDir) {
+                char* name = arenaAlloc(&worker->arena, myStrLen(d->d_name) + 1);
+                if (name == NULL) {
+                    reportError(d->d_name, ERRCOPY);
+                    continue;
+                }
+                myStrCpy(name, d->d_name, myStrLen(d->d_name));
+                batch.names[batch.count++] = name;
+
+                if (batch.count == FILE_BATCH_SIZE) {
+                    pushFiles(worker, &batch);
+                    batch.count = 0;
+                }
+                continue;
+            }
+
+            if (!joinPath(srcPath, task->src, d->d_name) || !joinPath(destPath, task->dest, d->d_name)) {
+                reportError(d->d_name, ERRCOPY);
+                continue;
+            }
+            if (meta_data.st_dev == worker->tree->destDev && meta_data.st_ino == worker->tree->destIno) {
+                reportError(srcPath, ERRSELF);
+                continue;
+            }
+
+            int status = myMkdirat(destFd, d->d_name, meta_data.st_mode | S_IRWXU);
+            if (status != 0 && status != -EEXIST) {
+                reportError(destPath, errorWithErrno(ERRMKDIR, -status));
+            } else if (!pushDir(worker, srcPath, destPath)) {
+                reportError(srcPath, ERRCOPY);
+            }
+        }
+    }
+    if (bytesRead < 0) reportError(task->src, errorWithErrno(ERRCOPY, -bytesRead));
+    if (batch.count > 0) pushFiles(worker, &batch);
+
+    releaseDir(dir);
 }
 
 /**
-Custom wrapper function for creat system call using inline assembly
-@pathname - path of file to create
-@mode - access mode of file
-@return - file descriptor if successful, -1 if error occurred
+Copies an entry of a directory that is not a directory. Regular files are
+copied with copyAt, and symlinks and special files are recreated with
+copySpecial. The entry is stat'd without following symlinks.
+@dir - directory the entry is in
+@name - name of entry
 **/
-int myCreat(const char* pathname, mode_t mode) {
-    long ret = -1;
+void copyEntry(struct openDir* dir, char* name) {
+    char srcPath[BUF_SIZE];
+    char destPath[BUF_SIZE];
+    struct stat meta_data;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)CREAT_SYSCALL), "r"(pathname), "r"((long)mode) :
-         "%rax","%rdi", "%rsi","memory" );
+    if (!joinPath(srcPath, dir->src, name) || !joinPath(destPath, dir->dest, name)) {
+        reportError(name, ERRCOPY);
+        return;
+    }
+    if (myFstatat(dir->fd, name, &meta_data, AT_SYMLINK_NOFOLLOW) != 0) {
+        reportError(srcPath, ERRSTAT);
+        return;
+    }
 
-    return ret;
+    //A directory here was created after its directory was read, so it is left out
+    if (S_ISDIR(meta_data.st_mode)) {
+        reportError(srcPath, ERRCOPY);
+        return;
+    }
+
+    struct fileRef src = { dir->fd, name, srcPath };
+    struct fileRef dest = { dir->destFd, name, destPath };
+    int status = S_ISREG(meta_data.st_mode) ? copyAt(&dest, &src, &meta_data) : copySpecial(&dest, &src, &meta_data);
+    if (status != 0) reportError(srcPath, status);
 }
 
 /**
-Custom wrapper function for mkdir system call using inline assembly
-@pathname - path of directory to create
-@mode - access mode of directory
-@return - file descriptor if successful, -1 if error occurred
+Drops a reference to a directory being copied. The last reference gives the
+copy the permissions of the source, as directories are created writable so
+they can be filled in, and closes both directories.
+@dir - directory to release
 **/
-int mymkdir(const char* pathname, mode_t mode) {
-    long ret = -1;
+void releaseDir(struct openDir* dir) {
+    if (__atomic_sub_fetch(&dir->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)MKDIR_SYSCALL), "r"(pathname), "r"((long)mode) :
-         "%rax","%rdi", "%rsi","memory" );
+    myFchmodat(dir->destFd, ".", dir->mode & 07777);
+    myClose(dir->destFd);
+    myClose(dir->fd);
+}
 
-    return ret;
+/**
+Pushes a directory onto the bottom of a worker's deque. The paths are copied
+into the worker's arena.
+@worker - worker to push onto
+@src - directory to copy
+@dest - path of its copy, already created
+@return - whether there was memory for the directory
+**/
+bool pushDir(struct treeWorker* worker, char* src, char* dest) {
+    struct treeTask task;
+    int srcLen = myStrLen(src);
+    int destLen = myStrLen(dest);
+
+    //Only the owner allocates from its arena, so this needs no lock
+    char* paths = arenaAlloc(&worker->arena, srcLen + destLen + 2);
+    if (paths == NULL) return false;
+    myStrCpy(paths, src, srcLen);
+    myStrCpy(paths + srcLen + 1, dest, destLen);
+
+    task.type = TASK_DIR;
+    task.src = paths;
+    task.dest = paths + srcLen + 1;
+    task.dir = NULL;
+    task.count = 0;
+    return pushTask(worker, &task);
 }
 
 /**
-Custom wrapper function for unlink system call using inline assembly
-@pathname - path of file to delete
-@return - result of deletion
+Pushes a batch of files onto the bottom of a worker's deque, holding a
+reference to their directory until they have been copied. If the batch cannot
+be pushed its files are copied now.
+@worker - worker to push onto
+@batch - batch of files, whose names are in the worker's arena
 **/
-int myUnlink(const char* pathname) {
-    long ret = -1;
+void pushFiles(struct treeWorker* worker, struct treeTask* batch) {
+    __atomic_add_fetch(&batch->dir->refs, 1, __ATOMIC_ACQ_REL);
+    if (pushTask(worker, batch)) return;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)UNLINK_SYSCALL), "r"(pathname) :
-         "%rax","%rdi","memory" );
-
-    return ret;
+    for (int i = 0; i < batch->count; i++) copyEntry(batch->dir, batch->names[i]);
+    releaseDir(batch->dir);
 }
 
 /**
-Custom wrapper function for rmdir system call using inline assembly
-@pathname - path of directory to delete
-@return - result of deletion
+Pushes a task onto the bottom of a worker's deque, doubling the size of the
+deque if it is full, and wakes a worker waiting for tasks
+@worker - worker to push onto
+@task - task to push, copied into the deque
+@return - whether there was memory for the task
 **/
-int myrmdir(const char* pathname) {
-    long ret = -1;
+bool pushTask(struct treeWorker* worker, struct treeTask* task) {
+    struct dirDeque* deque = &worker->deque;
+    struct treeCopy* tree = worker->tree;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)RMDIR_SYSCALL), "r"(pathname) :
-         "%rax","%rdi","memory" );
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->capacity) {
+        size_t capacity = (deque->capacity == 0) ? INITIAL_DEQUE_SIZE : deque->capacity * 2;
+        struct treeTask* tasks = myMmap(NULL, capacity * sizeof(struct treeTask), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (tasks == MAP_FAILED) {
+            pthread_mutex_unlock(&deque->lock);
+            return false;
+        }
 
-    return ret;
+        //Moves the tasks into the new ring, starting at the front
+        for (size_t i = 0; i < deque->bottom - deque->top; i++) {
+            tasks[i] = deque->tasks[(deque->top + i) % deque->capacity];
+        }
+        if (deque->tasks != NULL) myMunmap(deque->tasks, deque->capacity * sizeof(struct treeTask));
+        deque->bottom -= deque->top;
+        deque->top = 0;
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+    }
+
+    //Counts the task as pending before any worker can take it
+    __atomic_add_fetch(&tree->pending, 1, __ATOMIC_ACQ_REL);
+    deque->tasks[deque->bottom % deque->capacity] = *task;
+    deque->bottom++;
+    pthread_mutex_unlock(&deque->lock);
+
+    //Signals under the lock idle workers check for tasks under, so the wake up cannot be missed
+    pthread_mutex_lock(&tree->lock);
+    if (tree->idle > 0) pthread_cond_signal(&tree->wake);
+    pthread_mutex_unlock(&tree->lock);
+
+    return true;
 }
 
 /**
-Custom wrapper function for read system call using inline assembly
-@pathname - path of directory to delete
-@return - result of deletion
+Takes a task from a deque
+@deque - deque to take from
+@task - filled with the task taken
+@steal - take the oldest task from the top, rather than the newest from the bottom
+@return - whether the deque had a task
 **/
-int myRead(int fd, void* buf, size_t count) {
-    long ret = -1;
+bool popTask(struct dirDeque* deque, struct treeTask* task, bool steal) {
+    bool found = false;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "movq %4, %%rdx\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)READ_SYSCALL), "r"((long)fd), "r"(buf), "r"(count) :
-         "%rax","%rdi", "%rsi", "%rdx", "memory" );
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        if (steal) {
+            *task = deque->tasks[deque->top % deque->capacity];
+            deque->top++;
+        } else {
+            deque->bottom--;
+            *task = deque->tasks[deque->bottom % deque->capacity];
+        }
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
 
-    return ret;
+    return found;
 }
 
 /**
-Custom wrapper function for truncate system call using inline assembly
-@path - path of file to truncate
-@length - length to truncate file to
+Allocates memory from an arena of mmap'd blocks, which is only freed when the
+whole arena is freed. Allocations are aligned to 8 bytes, so they can hold
+structs as well as strings.
+@arena - arena to allocate from
+@size - number of bytes needed, less than ARENA_BLOCK_SIZE
+@return - pointer to memory, or NULL if a new block could not be mapped
 **/
-int myTruncate(const char* path, off_t length) {
-    long ret = -1;
+char* arenaAlloc(struct pathArena* arena, size_t size) {
+    arena->used = (arena->used + 7) / 8 * 8;
+    if (arena->block == NULL || arena->used + size > ARENA_BLOCK_SIZE) {
+        char* block = myMmap(NULL, ARENA_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) return NULL;
 
-    asm( "movq %1, %%rax\n\t"
-         "movq %2, %%rdi\n\t"
-         "movq %3, %%rsi\n\t"
-         "syscall\n\t"
-         "movq %%rax, %0\n\t" :
-         "=r"(ret) :
-         "r"((long)TRUNCATE_SYSCALL), "r"(path), "r"((long)length) :
-         "%rax","%rdi", "%rsi","memory" );
+        //Links the new block to the previous one so they can all be freed
+        *(char**) block = arena->block;
+        arena->block = block;
+        arena->used = sizeof(char*);
+    }
 
-    return ret;
+    char* ptr = arena->block + arena->used;
+    arena->used += size;
+    return ptr;
 }
 
 /**
-Custom implementation of strlen function
-@str - string to get the length of
-@return - length of string not including '\0'
+Frees every block of an arena
+@arena - arena to free
 **/
-int myStrLen(char* str) {
-    if (str == NULL) return -1;
+void arenaFree(struct pathArena* arena) {
+    while (arena->block != NULL) {
+        char* prev = *(char**) arena->block;
+        myMunmap(arena->block, ARENA_BLOCK_SIZE);
+        arena->block = prev;
+    }
+    arena->used = 0;
+}
 
-    int i;
-    for (i = 0; str[i] != '\0'; i++);
-    return i;
+/**
+Joins a directory path and a name with a '/'
+@buf - buffer of BUF_SIZE bytes to store path in
+@dir - directory path
+@name - name of entry in directory
+@return - whether the path fits in buf
+**/
+bool joinPath(char* buf, char* dir, char* name) {
+    int dirLen = myStrLen(dir);
+    int nameLen = myStrLen(name);
+    if (dirLen + nameLen + 2 > BUF_SIZE) return false;
+
+    myStrCpy(buf, dir, dirLen);
+    myStrCpy(buf + dirLen, "/", 1);
+    myStrCpy(buf + dirLen + 1, name, nameLen);
+    return true;
 }
 
 /**
-Custom implementation of strcpy function
-@dest - destination to copy string to
-@src - source to copy string from
-@n - size of string to copy in bytes
+Gets the last component of a path, ignoring trailing '/'s. The component is
+copied to the start of an internal buffer, so the result is only valid until
+the next call in the same thread.
+@path - path to get last component of
+@return - last component of path
 **/
-void myStrCpy(char* dest, const char* src, size_t n) {
-    //If src is NULL then operation is terminated.
-    if (src == NULL) {
-        return;
-    }
+char* baseName(char* path) {
+    static __thread char name[BUF_SIZE];
+    int end = myStrLen(path);
+    while (end > 1 && path[end - 1] == '/') end--;
 
-    size_t i;
-    for (i = 0; i < n; i++) {
-        dest[i] = src[i];
-    }
-    dest[i] = '\0';
+    int start = end;
+    while (start > 0 && path[start - 1] != '/') start--;
+
+    //A path of only '/'s is the root directory
+    if (start == end && end > 0) start--;
+
+    myStrCpy(name, path + start, end - start);
+    return name;
 }
 
 /**
-Compares two strings for equality - used for unit testing
-@str1 - first string
-@str2 - second string
-return - whether string is equal
+Prints an error message, holding a lock so that messages printed by worker
+threads are not interleaved
+@fileName - file name which causes error
+@flag - type of error
 **/
-bool strEqual(char* str1, char* str2) {
-    if (str1 == NULL || str2 == NULL) return (str1 == str2);
+void reportError(char* fileName, int flag) {
+    pthread_mutex_lock(&printLock);
+    writeErrorMsg(fileName, flag);
+    pthread_mutex_unlock(&printLock);
+}
 
-    if (myStrLen(str1) != myStrLen(str2)) return false;
+/**
+Copies source file to destination file/directory. Errors are returned rather
+than printed, so that copies done by worker threads can be reported in order.
+@dest - destination to copy to
+@src - source to be copied
+@src_meta_data - meta data of source, from the stat done by copySource
+@return - 0 if copied, otherwise error flag to pass to writeErrorMsg with src
+**/
+int mycp(char* dest, char* src, struct stat* src_meta_data) {
+    struct stat dest_meta_data;
+    struct fileRef srcRef = { AT_FDCWD, src, src };
+    struct fileRef destRef = { AT_FDCWD, dest, dest };
 
-    for (int i = 0; str1[i] != '\0'; i++) {
-        if (str1[i] != str2[i]) return false;
+    /*If destination is a directory, creates the copy in it with the last
+    component of src as its name, so that src may be in another directory*/
+    if (myFstatat(AT_FDCWD, dest, &dest_meta_data, 0) == 0 && S_ISDIR(dest_meta_data.st_mode)) {
+        destRef.dirfd = myOpenat(AT_FDCWD, dest, O_RDONLY | O_DIRECTORY, 0);
+        if (destRef.dirfd < 0) return errorWithErrno(ERRCREATE, -destRef.dirfd);
+        destRef.name = baseName(src);
     }
 
-    return true;
+    int status = copyAt(&destRef, &srcRef, src_meta_data);
+    if (destRef.dirfd != AT_FDCWD) myClose(destRef.dirfd);
+    return status;
 }
 
 /**
-Custom implementation of itoa function
-@num - positive integer to convert to string
-@str - char* to store converted string
+Copies a file to a destination file, each named relative to an open directory.
+The destination is truncated if it exists, otherwise it is created with the
+permissions of the source. The source is opened first, so that an existing
+destination is left as it was if the source cannot be read.
+@dest - destination file to copy to
+@src - source file to be copied
+@src_meta_data - meta data of source
+@return - 0 if copied, otherwise error flag to pass to writeErrorMsg with src
 **/
-void myitoa(unsigned int num, char* str) {
-    char intStr[MAX_INT_DIGITS + 1];
-    int i = 0;
+int copyAt(struct fileRef* dest, struct fileRef* src, struct stat* src_meta_data) {
+    /*Refuses to copy a file onto itself, which would truncate it before it is
+    read. Both paths are followed through symlinks, as they are opened*/
+    struct stat dest_meta_data;
+    bool destExists = (myFstatat(dest->dirfd, dest->name, &dest_meta_data, 0) == 0);
+    if (destExists && dest_meta_data.st_dev == src_meta_data->st_dev && dest_meta_data.st_ino == src_meta_data->st_ino) {
+        return ERRSAME;
+    }
 
-    //Assigns 0 string if num is zero
-    if (num == 0) {
-        str[0] = '0';
-        str[1] = '\0';
-        return;
+    //With --update, leaves a destination that is already the same as the source
+    if (options.update != UPDATE_NONE && isUnchanged(dest, src, src_meta_data)) {
+        __atomic_add_fetch(&stats.filesSkipped, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats.bytesSkipped, src_meta_data->st_size, __ATOMIC_RELAXED);
+        return 0;
     }
 
-    //Gets digits from least to most significant (reverse order in array)
-    while (num) {
-        //Gets least significant bit
-        intStr[i++] = num % 10;
-        //Reduces size of num by factor of 10
-        num /= 10;
+    //Open source file for reading
+    int srcFd = myOpenat(src->dirfd, src->name, O_RDONLY, 0);
+    if (srcFd < 0) return errorWithErrno(ERROPEN, -srcFd);
+
+    /*With --delta, an existing regular destination is not truncated, so that
+    only the chunks that differ from the source are rewritten*/
+    bool delta = options.delta && S_ISREG(src_meta_data->st_mode)
+        && src_meta_data->st_size > 0 && destExists && S_ISREG(dest_meta_data.st_mode);
+
+    int destFd = myOpenat(dest->dirfd, dest->name, O_RDWR | O_CREAT | (delta ? 0 : O_TRUNC), src_meta_data->st_mode);
+    if (destFd < 0) {
+        myClose(srcFd);
+        return errorWithErrno(ERRCREATE, -destFd);
     }
-    intStr[i] = '\0';
 
-    //Converts digits to ASCII and reorders in new array
-    for (int j = 0, k = i - 1; j < i; j++, k--) {
-        str[k] = intStr[j] + ASCII_CONVERSION_INT;
+    //Sets up the file to be copied, the buffer is only allocated if it is needed
+    struct copyFile file;
+    initCopyFile(&file, destFd, srcFd, src_meta_data);
+
+    /*Prints the line with one write so that lines printed by worker threads
+    are not interleaved*/
+    if (options.verbose) {
+        char line[2 * BUF_SIZE + 64];
+        char numStr[MAX_INT_DIGITS + 1];
+        char* parts[9] = { "'", src->path, "' -> '", dest->path, "' (",
+            delta ? "delta" : options.direct ? "direct" : (char*) ENGINE_NAMES[options.engine], " engine, ", numStr, " byte buffer)\n" };
+        int lineLen = 0;
+
+        myitoa(file.bufSize, numStr);
+        for (int i = 0; i < 9; i++) {
+            int partLen = myStrLen(parts[i]);
+            if (lineLen + partLen >= (int) sizeof(line)) break;
+            myStrCpy(line + lineLen, parts[i], partLen);
+            lineLen += partLen;
+        }
+        myPrint(line);
     }
 
-    str[i] = '\0';
+    /*Clones source into destination if selected. If cloning is not supported
+    the data is copied, unless --reflink=always was given*/
+    bool cloned = false;
+    bool deltaCopied = false;
+    int error = 0;
+    long copied = src_meta_data->st_size;
+
+    /*Compares the existing destination with the source and rewrites the chunks
+    that differ. If it cannot be read the destination is truncated and copied
+    in full, as without --delta*/
+    if (delta) {
+        deltaCopied = (deltaCopy(&file, src_meta_data->st_size) >= 0);
+        if (!deltaCopied) {
+            file.crc = 0;
+            file.crcLen = 0;
+            myFtruncate(destFd, 0);
+            myLseek(srcFd, 0, SEEK_SET);
+            myLseek(destFd, 0, SEEK_SET);
+        }
+    }
+
+    if (!deltaCopied && options.reflink != REFLINK_NEVER) {
+        int ret = reflinkFile(destFd, srcFd);
+        cloned = (ret == 0);
+        if (!cloned && options.reflink == REFLINK_ALWAYS) error = errorWithErrno(ERRCLONE, -ret);
+    }
+
+    /*Reserves space for the whole file before copying so that it is allocated
+    in as few extents as possible. Skipped in sparse mode, where holes must
+    stay unallocated*/
+    if (!cloned && !deltaCopied && options.reflink != REFLINK_ALWAYS && !options.sparse && src_meta_data->st_size > 0) {
+        preallocate(destFd, src_meta_data->st_size);
+    }
+
+    /*Write data from source file to destination file. Streams report no size,
+    so they are always read until the end. Regular files reporting a size of 0
+    are read with a single read call, which finds the end of an empty file
+    without setting up an engine, and still copies files in /proc that only
+    report their size once read. In sparse mode only data regions are written,
+    falling back to a full copy from the start if the filesystem cannot report
+    holes*/
+    bool unsized = file.stream || src_meta_data->st_size == 0;
+    if (!cloned && !deltaCopied && options.reflink != REFLINK_ALWAYS) {
+        long ret = -1;
+        if (options.sparse && !unsized) {
+            ret = sparseCopy(&file, src_meta_data->st_size);
+            if (ret < 0) {
+                file.crc = 0;
+                file.crcLen = 0;
+                myLseek(srcFd, 0, SEEK_SET);
+                myLseek(destFd, 0, SEEK_SET);
+            }
+        }
+        if (ret < 0) ret = (!file.stream && unsized) ? readWriteEngine(&file, -1) : writeToFile(&file, -1);
+        if (ret < 0) error = errorWithErrno(ERRCOPY, -ret);
+        if (ret > 0 && unsized) copied = ret;
+    }
+
+    //Checks the copy against the checksum of the source
+    if (options.verify && error == 0) {
+        error = verifyCopy(&file, copied);
+    }
+
+    /*With --update, gives the copy the times of the source, so that the next
+    run finds it unchanged. Done last, as writing data changes the times*/
+    if (options.update != UPDATE_NONE && error == 0) {
+        struct timespec times[2] = { src_meta_data->st_atim, src_meta_data->st_mtim };
+        myUtimensat(destFd, NULL, times, 0);
+        __atomic_add_fetch(&stats.filesCopied, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats.bytesCopied, copied, __ATOMIC_RELAXED);
+    }
+
+    freeCopyFile(&file);
+    myClose(destFd);
+    myClose(srcFd);
+    return error;
 }
 
 /**
-Gets character signifying whether a file is a directory or not
-@meta_data - meta data of file
-@dir - character array to store directory character
+Recreates an entry of a directory copied with -r that is not a regular file or
+directory. Symlinks are copied as links to the same target. FIFOs, sockets and
+devices are created with mknod rather than read, as reading a FIFO would wait
+for a writer and reading a device such as /dev/zero would never end. An
+existing destination that is not a directory is replaced.
+@dest - destination entry to create
+@src - symlink or special file to copy
+@src_meta_data - meta data of src, not following symlinks
+@return - 0 if created, otherwise error flag to pass to writeErrorMsg with src
 **/
-void getDirChar(struct stat meta_data, char* dir) {
-    dir[0] = S_ISDIR(meta_data.st_mode) ? 'd' : '-';
-    dir[1] = '\0';
+int copySpecial(struct fileRef* dest, struct fileRef* src, struct stat* src_meta_data) {
+    char target[BUF_SIZE];
+    long status;
+
+    if (S_ISLNK(src_meta_data->st_mode)) {
+        //readlink does not terminate the target, and fills the buffer if it is too long
+        status = myReadlinkat(src->dirfd, src->name, target, BUF_SIZE);
+        if (status < 0) return errorWithErrno(ERROPEN, -status);
+        if (status >= BUF_SIZE) return errorWithErrno(ERROPEN, ENAMETOOLONG);
+        target[status] = '\0';
+
+        status = mySymlinkat(target, dest->dirfd, dest->name);
+        if (status == -EEXIST && myUnlinkat(dest->dirfd, dest->name, 0) == 0) {
+            status = mySymlinkat(target, dest->dirfd, dest->name);
+        }
+    } else {
+        status = myMknodat(dest->dirfd, dest->name, src_meta_data->st_mode, src_meta_data->st_rdev);
+        if (status == -EEXIST && myUnlinkat(dest->dirfd, dest->name, 0) == 0) {
+            status = myMknodat(dest->dirfd, dest->name, src_meta_data->st_mode, src_meta_data->st_rdev);
+        }
+    }
+
+    return (status < 0) ? errorWithErrno(ERRCREATE, -status) : 0;
 }
 
 /**
-Convenient wrapper for myWrite that prints to stdout
-@str - string to print to stdout
+Checks whether a destination file already holds the same data as its source,
+so that --update can skip copying it. The sizes must match, and either the
+modification times (--update) or the hashes of the contents (--update=checksum).
+Copies made with --update are given the times of their source, so files that
+have not changed since the last run match.
+@dest - destination file
+@src - source file
+@src_meta_data - meta data of source
+@return - whether the destination is the same as the source
 **/
-void myPrint(char* str) {
-    myWrite(stdout, str, myStrLen(str));
+bool isUnchanged(struct fileRef* dest, struct fileRef* src, struct stat* src_meta_data) {
+    struct stat dest_meta_data;
+
+    //Streams have no size or time that says whether they have changed
+    if (!S_ISREG(src_meta_data->st_mode)) return false;
+    if (myFstatat(dest->dirfd, dest->name, &dest_meta_data, 0) != 0 || !S_ISREG(dest_meta_data.st_mode)) return false;
+    if (dest_meta_data.st_size != src_meta_data->st_size) return false;
+
+    if (options.update == UPDATE_MTIME) {
+        return (dest_meta_data.st_mtim.tv_sec == src_meta_data->st_mtim.tv_sec
+            && dest_meta_data.st_mtim.tv_nsec == src_meta_data->st_mtim.tv_nsec);
+    }
+
+    //Compares hashes of the contents, which is slower but ignores times
+    int srcFd = myOpenat(src->dirfd, src->name, O_RDONLY, 0);
+    int destFd = myOpenat(dest->dirfd, dest->name, O_RDONLY, 0);
+    bool srcOk = false;
+    bool destOk = false;
+    bool same = false;
+    if (srcFd >= 0 && destFd >= 0) same = (hashFile(srcFd, &srcOk) == hashFile(destFd, &destOk));
+    if (srcFd >= 0) myClose(srcFd);
+    if (destFd >= 0) myClose(destFd);
+
+    return (same && srcOk && destOk);
 }
 
 /**
- Prints cp error message
- @fileName - file name which causes error
- @flag - type of error
+Hashes the contents of a file from its current offset to the end. Each 8 byte
+word is mixed into a 64-bit hash with a multiply and shift, which is fast
+enough that hashing is limited by reading the file. The hash is not
+cryptographic, it only detects files that differ.
+@fd - file to hash
+@ok - set to whether the whole file was read
+@return - hash of contents
 **/
-void writeErrorMsg(char* fileName, int flag) {
-    if (flag == ERRSTAT)  {
-        myPrint("mycp: cannot stat '");
-        myPrint(fileName);
-        myPrint("' No such file or directory");
-        myPrint("\n");
-    } else if (flag == ERRREC) {
-        myPrint("mycp: -r not specified; omitting directory '");
-        myPrint(fileName);
-        myPrint("'\n");
-    } else if (flag == ERRDEST) {
-        myPrint("mycp: missing destination file operand after '");
-        myPrint(fileName);
-        myPrint("'\n");
-    } else if (flag == ERRDIR) {
-        myPrint("mycp: target '");
-        myPrint(fileName);
-        myPrint("' is not a directory\n");
-    } else if (flag == ERRPERM) {
-        myPrint("mycp: cannot open '");
-        myPrint(fileName);
-        myPrint("' for reading: Permission denied\n");
-    }
-}
+unsigned long hashFile(int fd, bool* ok) {
+    char buf[HASH_BUF_SIZE] __attribute__((aligned(8)));
+    unsigned long hash = HASH_MULTIPLIER;
+    unsigned long length = 0;
+    long bytesRead;
 
+    *ok = false;
+    while ((bytesRead = myRead(fd, buf, HASH_BUF_SIZE)) != 0) {
+        if (bytesRead == -EINTR) continue;
+        if (bytesRead < 0) return 0;
 
-/**
-Runs a given list of unit tests.
-Iterates over each unit test in the list of test functions. If calling the
-current function returns true then the test has passed, otherwise it has failed.
-@testFunctions - list of unit tests to run
-@numTests - num tests to run
-@returns - number of passing unit tests
-*/
-int runTests(bool (*testFunctions[]) (), int numTests) {
-    //Number of tests that have passed
-    int numPassingTests = 0;
-    char printBuf[MAX_INT_DIGITS];
+        //Pads the last partial word with zeroes
+        while (bytesRead % 8 != 0) buf[bytesRead++] = 0;
 
-    //Lists result of each unit test
-    int i;
-    for (i = 0; i < numTests; i++) {
-        if ((*testFunctions[i]) ()) {
-            numPassingTests += 1;
-            myPrint(GREEN);
-            myPrint("\n***TEST ");
-            myitoa(i + 1, printBuf);
-            myPrint(printBuf);
-            myPrint(" PASSED***\n");
-        } else {
-            myPrint(RED);
-            myPrint("\n***TEST ");
-            myitoa(i + 1, printBuf);
-            myPrint(printBuf);
-            myPrint(" FAILED***\n");
+        unsigned long* words = (unsigned long*) buf;
+        for (long i = 0; i < bytesRead / 8; i++) {
+            hash = (hash ^ words[i]) * HASH_MULTIPLIER;
+            hash ^= hash >> 32;
         }
+        length += bytesRead;
     }
 
-    //Displays total number of unit tests which have passed
-    myPrint("\n***");
-    (numPassingTests > 0) ? myitoa(numPassingTests, printBuf) : myStrCpy(printBuf, "0", 1);
-    myPrint(printBuf);
-    myPrint("/");
-    myitoa(i, printBuf);
-    myPrint(printBuf);
-    myPrint(" TESTS PASSED***\n");
+    *ok = true;
+    return (hash ^ length) * HASH_MULTIPLIER;
+}
 
-    myPrint(WHITE);
-    return numPassingTests;
+/**
+Prints the number of files and bytes copied and skipped by --update
+**/
+void printUpdateStats() {
+    char numStr[MAX_LONG_DIGITS + 1];
+
+    myPrint("mycp: copied ");
+    myltoa(stats.filesCopied, numStr);
+    myPrint(numStr);
+    myPrint(" files (");
+    myltoa(stats.bytesCopied, numStr);
+    myPrint(numStr);
+    myPrint(" bytes), skipped ");
+    myltoa(stats.filesSkipped, numStr);
+    myPrint(numStr);
+    myPrint(" unchanged files (");
+    myltoa(stats.bytesSkipped, numStr);
+    myPrint(numStr);
+    myPrint(" bytes)\n");
 }
 
 /**
-Initialises the array of tests to be run with the address of each unit test function.
-@testFunctions - list of test functions to be called
+Clones src into dest with the FICLONE ioctl, so that both files share the same
+data blocks on copy-on-write filesystems (e.g. btrfs, XFS). This takes the same
+time however large the file is.
+@dest - fd of destination file, opened for writing
+@src - fd of source file
+@return - 0 if successful, negative error number otherwise (e.g. EOPNOTSUPP, EXDEV)
 **/
-void initTests(bool (*testFunctions[]) ()) {
-    testFunctions[0] = strEqualTest1;
-    testFunctions[1] = strEqualTest2;
-    testFunctions[2] = strEqualTest3;
-    testFunctions[3] = strEqualTest4;
-    testFunctions[4] = myitoaTest1;
-    testFunctions[5] = myitoaTest2;
-    testFunctions[6] = myitoaTest3;
-    testFunctions[7] = myitoaTest4;
-    testFunctions[8] = myStrCpyTest1;
-    testFunctions[9] = myStrCpyTest2;
+int reflinkFile(int dest, int src) {
+    return myIoctl(dest, FICLONE, src);
+}
+
+/**
+Reserves size bytes of disk space for dest with fallocate, so the filesystem
+can allocate the file in few large extents instead of growing it a block at a
+time. FALLOC_FL_KEEP_SIZE is used so the size of dest only grows as data is
+written. Filesystems that do not support fallocate are ignored.
+@dest - fd of destination file
+@size - number of bytes to reserve
+@return - 0 if successful, negative error number otherwise (e.g. EOPNOTSUPP)
+**/
+int preallocate(int dest, off_t size) {
+    int status;
+    while ((status = myFallocate(dest, FALLOC_FL_KEEP_SIZE, 0, size)) == -EINTR);
+    return status;
+}
+
+/**
+Writes data from src to dest with the engine selected by --engine, or the
+O_DIRECT engine if --direct was given. By default
+copy_file_range is tried first so that the kernel copies the data without it
+passing through user space, or splice if src is a stream, which copy_file_range
+cannot read. If the selected engine is unsupported for the two files (e.g.
+EXDEV for copy_file_range, ENODEV for mmap) the data is copied with read and
+write.
+@file - file being copied
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number
+**/
+long writeToFile(struct copyFile* file, long len) {
+    long ret;
+
+    //--direct bypasses the page cache, which the other engines all copy through
+    if (options.direct) return directEngine(file, len);
+
+    //With --verify, streams are checksummed as they are copied, as they cannot be read again
+    if (options.verify && file->stream) return readWriteEngine(file, len);
+
+    if (options.engine == ENGINE_RW) {
+        return readWriteEngine(file, len);
+    } else if (options.engine == ENGINE_MMAP) {
+        ret = mmapEngine(file, len);
+    } else if (options.engine == ENGINE_SPLICE || (options.engine == ENGINE_AUTO && file->stream)) {
+        ret = spliceEngine(file, len);
+    } else if (options.engine == ENGINE_URING) {
+        ret = uringEngine(file, len);
+    } else {
+        ret = copyFileRangeEngine(file, len);
+    }
+
+    if (ret == -EXDEV || ret == -ENOSYS || ret == -EINVAL || ret == -EOPNOTSUPP || ret == -ENODEV || ret == -EACCES) {
+        /*The engines only return these errors when the two files do not
+        support them, which is found before anything is copied, so the file
+        offsets are where they started. Data splice has already taken from a
+        stream is written by spliceEngine itself*/
+        ret = readWriteEngine(file, len);
+    }
+
+    return ret;
+}
+
+/**
+Copies data from src to dest with copy_file_range until len bytes or the end
+of src are reached. The file offsets of both files are advanced by the amount
+copied.
+@file - file being copied
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number if a call failed
+**/
+long copyFileRangeEngine(struct copyFile* file, long len) {
+    long total = 0;
+    long ret;
+
+    while (len < 0 || total < len) {
+        size_t chunk = (len < 0 || len - total > CFR_CHUNK_SIZE) ? CFR_CHUNK_SIZE : (size_t) (len - total);
+        ret = myCopyFileRange(file->src, NULL, file->dest, NULL, chunk, 0);
+        if (ret == 0) break;
+        if (ret == -EINTR) continue;
+        if (ret < 0) return ret;
+        total += ret;
+    }
+
+    return total;
+}
+
+/**
+Copies data from src to dest through a page aligned buffer with read and write
+until len bytes or the end of src are reached. The buffer is allocated on first
+use with the size chosen for the file. Interrupted reads are retried and
+partial writes are completed before the next read.
+@file - file being copied
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number if a read or write failed
+**/
+long readWriteEngine(struct copyFile* file, long len) {
+    long total = 0;
+    long bytesRead;
+
+    if (allocCopyBuffer(file) != 0) return -ENOMEM;
+
+    while (len < 0 || total < len) {
+        size_t count = (len < 0 || len - total > (long) file->bufSize) ? file->bufSize : (size_t) (len - total);
+        bytesRead = myRead(file->src, file->buf, count);
+        if (bytesRead == -EINTR) continue;
+        if (bytesRead < 0) return bytesRead;
+        if (bytesRead == 0) break;
+
+        long ret = writeAll(file->dest, file->buf, bytesRead);
+        if (ret < 0) return ret;
+        addChecksum(file, file->buf, bytesRead);
+        total += bytesRead;
+    }
+
+    return total;
+}
+
+/**
+Maps the page aligned buffer of a copyFile with the size chosen for the file,
+unless it has already been mapped
+@file - file being copied
+@return - 0 if successful, -ENOMEM otherwise
+**/
+int allocCopyBuffer(struct copyFile* file) {
+    if (file->buf != NULL) return 0;
+
+    file->buf = myMmap(NULL, file->bufSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (file->buf == MAP_FAILED) {
+        file->buf = NULL;
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+/**
+Copies data from src to dest with read and write while bypassing the page
+cache, so that copying large files does not evict the cached data of other
+programs. O_DIRECT is turned on for both files, which requires offsets, lengths
+and the buffer to be aligned to the logical block size of the devices. The
+buffer is page aligned and a multiple of the page size, so it is aligned for
+any block size up to a page. The last block of a file whose size is not
+aligned is written after turning O_DIRECT off for dest. If O_DIRECT cannot be
+used the data is copied through the page cache and dropped from it instead.
+@file - file being copied
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number if a read or write failed
+**/
+long directEngine(struct copyFile* file, long len) {
+    long total = 0;
+    long ret = 0;
+
+    if (allocCopyBuffer(file) != 0) return -ENOMEM;
+
+    //O_DIRECT needs both files to support it and the current offsets to be aligned
+    off_t srcOffset = myLseek(file->src, 0, SEEK_CUR);
+    off_t destOffset = myLseek(file->dest, 0, SEEK_CUR);
+    size_t srcAlign = directAlignment(file->src);
+    size_t destAlign = directAlignment(file->dest);
+    size_t align = (srcAlign > destAlign) ? srcAlign : destAlign;
+
+    bool direct = (srcAlign > 0 && destAlign > 0 && align <= PAGE_SIZE && srcOffset >= 0 && destOffset >= 0
+        && srcOffset % align == 0 && destOffset % align == 0);
+    if (direct) direct = (setDirect(file->src, true) == 0 && setDirect(file->dest, true) == 0);
+    if (!direct) {
+        setDirect(file->src, false);
+        setDirect(file->dest, false);
+        return dropCacheCopy(file, len);
+    }
+
+    while (len < 0 || total < len) {
+        size_t count = (len < 0 || len - total > (long) file->bufSize) ? file->bufSize : (size_t) (len - total);
+
+        //Copies an unaligned remainder of len through the page cache
+        if (count % align != 0) {
+            setDirect(file->src, false);
+            setDirect(file->dest, false);
+            ret = dropCacheCopy(file, count);
+            if (ret > 0) total += ret;
+            break;
+        }
+
+        long bytesRead = myRead(file->src, file->buf, count);
+        if (bytesRead == -EINTR) continue;
+        if (bytesRead <= 0) {
+            ret = bytesRead;
+            break;
+        }
+
+        //Writes the aligned part, then any unaligned tail at the end of src without O_DIRECT
+        size_t aligned = bytesRead / align * align;
+        ret = (aligned > 0) ? writeAll(file->dest, file->buf, aligned) : 0;
+        if (ret >= 0 && (size_t) bytesRead > aligned) {
+            setDirect(file->dest, false);
+            ret = writeAll(file->dest, file->buf + aligned, bytesRead - aligned);
+            if (ret >= 0) myFadvise(file->dest, destOffset + total + aligned, bytesRead - aligned, POSIX_FADV_DONTNEED);
+        }
+        if (ret < 0) break;
+        addChecksum(file, file->buf, bytesRead);
+        total += bytesRead;
+    }
+
+    //Leaves the files as they were opened so they can be used by other engines
+    setDirect(file->src, false);
+    setDirect(file->dest, false);
+    return (ret < 0) ? ret : total;
+}
+
+/**
+Copies data through the page cache with the read/write engine, in chunks of
+DROP_CACHE_CHUNK, and drops each chunk from the page cache once it has been
+copied. Writeback of each chunk of dest is started as soon as it is written,
+and is waited for one chunk later, so that the pages are clean and can be
+dropped without stalling every chunk on the disk.
+@file - file being copied
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number if a read or write failed
+**/
+long dropCacheCopy(struct copyFile* file, long len) {
+    off_t srcOffset = myLseek(file->src, 0, SEEK_CUR);
+    off_t destOffset = myLseek(file->dest, 0, SEEK_CUR);
+    long total = 0;
+    long prevLen = 0;
+
+    while (len < 0 || total < len) {
+        long chunk = (len < 0 || len - total > DROP_CACHE_CHUNK) ? DROP_CACHE_CHUNK : len - total;
+        long ret = readWriteEngine(file, chunk);
+        if (ret < 0) return ret;
+
+        //Files that cannot seek (e.g. pipes) have no cached pages to drop
+        if (srcOffset >= 0) myFadvise(file->src, srcOffset + total, ret, POSIX_FADV_DONTNEED);
+        if (destOffset >= 0) {
+            mySyncFileRange(file->dest, destOffset + total, ret, SYNC_FILE_RANGE_WRITE);
+            if (prevLen > 0) {
+                mySyncFileRange(file->dest, destOffset + total - prevLen, prevLen,
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+                myFadvise(file->dest, destOffset + total - prevLen, prevLen, POSIX_FADV_DONTNEED);
+            }
+        }
+
+        total += ret;
+        prevLen = ret;
+        if (ret < chunk) break;
+    }
+
+    //Drops the last chunk of dest once it has been written back
+    if (destOffset >= 0 && prevLen > 0) {
+        mySyncFileRange(file->dest, destOffset + total - prevLen, prevLen,
+            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        myFadvise(file->dest, destOffset + total - prevLen, prevLen, POSIX_FADV_DONTNEED);
+    }
+
+    return total;
+}
+
+/**
+Finds the alignment O_DIRECT needs for offsets and lengths in a file, which is
+the logical block size of its device. statx reports it with STATX_DIOALIGN on
+Linux 6.1 and later, otherwise DIRECT_IO_ALIGN is assumed.
+@fd - file to check
+@return - alignment in bytes, or 0 if the file does not support O_DIRECT
+**/
+size_t directAlignment(int fd) {
+    struct statx stx;
+
+    if (myStatx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) != 0 || !(stx.stx_mask & STATX_DIOALIGN)) {
+        return DIRECT_IO_ALIGN;
+    }
+
+    //The buffer must also be aligned, the larger of the two alignments is used
+    if (stx.stx_dio_offset_align == 0) return 0;
+    return (stx.stx_dio_mem_align > stx.stx_dio_offset_align) ? stx.stx_dio_mem_align : stx.stx_dio_offset_align;
+}
+
+/**
+Turns O_DIRECT on or off for an open file
+@fd - file to change
+@direct - whether reads and writes should bypass the page cache
+@return - 0 if successful, negative error number otherwise (e.g. EINVAL if the
+filesystem does not support O_DIRECT)
+**/
+int setDirect(int fd, bool direct) {
+    int flags = myFcntl(fd, F_GETFL, 0);
+    if (flags < 0) return flags;
+
+    flags = direct ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    return myFcntl(fd, F_SETFL, flags);
+}
+
+/**
+Copies data from src to dest by mapping src read-only and writing directly from
+the mapping, so the data is not copied into a separate buffer. Large files are
+mapped in windows of MMAP_WINDOW_SIZE, each advised as MADV_SEQUENTIAL so the
+kernel reads ahead aggressively and drops pages behind the copy. The file
+offsets of both files are advanced by the amount copied.
+@file - file being copied, src must be a regular file
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number (e.g. ENODEV if src
+cannot be mapped)
+**/
+long mmapEngine(struct copyFile* file, long len) {
+    struct stat src_meta_data;
+    long total = 0;
+
+    //Finds where to start copying and how much of src is left
+    off_t offset = myLseek(file->src, 0, SEEK_CUR);
+    if (offset < 0) return offset;
+    if (myFstat(file->src, &src_meta_data) != 0) return -EBADF;
+    if (!S_ISREG(src_meta_data.st_mode)) return -ENODEV;
+
+    long remaining = src_meta_data.st_size - offset;
+    if (len >= 0 && len < remaining) remaining = len;
+
+    while (total < remaining) {
+        //Windows start on a page boundary, so the first may begin before offset
+        off_t windowStart = (offset + total) / PAGE_SIZE * PAGE_SIZE;
+        size_t skip = offset + total - windowStart;
+        size_t count = (remaining - total > MMAP_WINDOW_SIZE - (long) skip) ? MMAP_WINDOW_SIZE - skip : (size_t) (remaining - total);
+
+        char* window = myMmap(NULL, skip + count, PROT_READ, MAP_SHARED, file->src, windowStart);
+        if (window == MAP_FAILED) return (total > 0) ? -EIO : -ENODEV;
+        myMadvise(window, skip + count, MADV_SEQUENTIAL);
+
+        long ret = writeAll(file->dest, window + skip, count);
+        if (ret >= 0) addChecksum(file, window + skip, count);
+        myMunmap(window, skip + count);
+        if (ret < 0) return ret;
+
+        total += count;
+    }
+
+    //Moves the source offset past the data copied, as the other engines do
+    myLseek(file->src, offset + total, SEEK_SET);
+    return total;
+}
+
+/**
+Copies data from src to dest inside the kernel without it passing through user
+space, for any type of src. Regular files of known size are copied with
+sendfile. Other sources are spliced into dest: directly if src is a pipe,
+otherwise through a pipe sized to the copy buffer, which is emptied into dest
+after each splice from src. The file offsets of both files are advanced by the
+amount copied.
+@file - file being copied
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number (e.g. EINVAL if src
+or dest does not support splice)
+**/
+long spliceEngine(struct copyFile* file, long len) {
+    struct stat src_meta_data;
+    long total = 0;
+    long ret;
+
+    if (myFstat(file->src, &src_meta_data) != 0) return -EBADF;
+
+    //sendfile reads from regular files through the page cache without a pipe
+    if (!file->stream) {
+        while (len < 0 || total < len) {
+            size_t chunk = (len < 0 || len - total > CFR_CHUNK_SIZE) ? CFR_CHUNK_SIZE : (size_t) (len - total);
+            ret = mySendfile(file->dest, file->src, NULL, chunk);
+            if (ret == 0) break;
+            if (ret == -EINTR) continue;
+            if (ret < 0) return ret;
+            total += ret;
+        }
+        return total;
+    }
+
+    //A pipe source can be spliced straight into dest
+    if (S_ISFIFO(src_meta_data.st_mode)) {
+        while (len < 0 || total < len) {
+            size_t chunk = (len < 0 || len - total > (long) file->bufSize) ? file->bufSize : (size_t) (len - total);
+            ret = mySplice(file->src, NULL, file->dest, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (ret == 0) break;
+            if (ret == -EINTR) continue;
+            if (ret < 0) return ret;
+            total += ret;
+        }
+        return total;
+    }
+
+    //Other sources are spliced into a pipe, then from the pipe into dest
+    int pipeFds[2];
+    ret = myPipe2(pipeFds, O_CLOEXEC);
+    if (ret < 0) return ret;
+
+    //A larger pipe moves more data per splice, the kernel may refuse the size
+    long pipeSize = myFcntl(pipeFds[1], F_SETPIPE_SZ, file->bufSize);
+    if (pipeSize <= 0) pipeSize = PAGE_SIZE * 16;
+
+    while (len < 0 || total < len) {
+        size_t chunk = (len < 0 || len - total > pipeSize) ? (size_t) pipeSize : (size_t) (len - total);
+        long inPipe = mySplice(file->src, NULL, pipeFds[1], NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (inPipe == 0) break;
+        if (inPipe == -EINTR) continue;
+        if (inPipe < 0) {
+            ret = inPipe;
+            break;
+        }
+
+        //Empties the pipe before the next splice from src, so no data is left in it
+        while (inPipe > 0) {
+            ret = mySplice(pipeFds[0], NULL, file->dest, NULL, inPipe, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (ret == -EINTR) continue;
+            if (ret <= 0) break;
+            inPipe -= ret;
+            total += ret;
+        }
+
+        /*The data in the pipe has already been taken from src, which cannot be
+        read again, so if dest does not accept it from splice (e.g. EINVAL if
+        dest is opened with O_APPEND) it is written from the pipe with read and
+        write, and the rest of src is copied with the read/write engine*/
+        if (inPipe > 0) {
+            ret = drainPipe(file, pipeFds[0], inPipe);
+            if (ret < 0) break;
+            total += inPipe;
+            if (len < 0 || total < len) {
+                ret = readWriteEngine(file, (len < 0) ? -1 : len - total);
+                if (ret > 0) total += ret;
+            }
+            break;
+        }
+        ret = 0;
+    }
+
+    myClose(pipeFds[0]);
+    myClose(pipeFds[1]);
+    return (ret < 0) ? ret : total;
+}
+
+/**
+Writes the data left in a pipe to dest with read and write, through the
+buffer of the read/write engine
+@file - file being copied
+@pipeFd - read end of pipe
+@count - number of bytes in the pipe
+@return - 0 if all count bytes were written, or negative error number
+**/
+long drainPipe(struct copyFile* file, int pipeFd, long count) {
+    if (allocCopyBuffer(file) != 0) return -ENOMEM;
+
+    while (count > 0) {
+        long bytesRead = myRead(pipeFd, file->buf, (count > (long) file->bufSize) ? file->bufSize : (size_t) count);
+        if (bytesRead == -EINTR) continue;
+        if (bytesRead < 0) return bytesRead;
+        if (bytesRead == 0) return -EIO;
+
+        long ret = writeAll(file->dest, file->buf, bytesRead);
+        if (ret < 0) return ret;
+        count -= bytesRead;
+    }
+
+    return 0;
+}
+
+/**
+Copies data from src to dest with io_uring, so that reads from src overlap with
+writes to dest. options.queueDepth buffers are registered with the kernel as
+fixed buffers, avoiding mapping them on every request. Each buffer is read into
+from the next chunk of src, and once full is written to the same offset of dest
+while the other buffers are being read or written. Short reads and writes are
+resubmitted for the rest of the chunk, as are requests the kernel did not
+take when they were submitted. The file offsets of both files are
+advanced by the amount copied.
+@file - file being copied, src must be a regular file
+@len - number of bytes to copy, or negative to copy until the end of src
+@return - number of bytes copied, or negative error number (e.g. EOPNOTSUPP if
+io_uring or fixed buffers are unavailable)
+**/
+long uringEngine(struct copyFile* file, long len) {
+    struct stat src_meta_data;
+    struct uringQueue ring;
+    struct uringSlot slots[MAX_QUEUE_DEPTH];
+    struct iovec iovecs[MAX_QUEUE_DEPTH];
+    int depth = options.queueDepth;
+
+    //Reads and writes are at explicit offsets, so src must be seekable
+    if (file->stream) return -ENODEV;
+    off_t srcStart = myLseek(file->src, 0, SEEK_CUR);
+    off_t destStart = myLseek(file->dest, 0, SEEK_CUR);
+    if (srcStart < 0) return srcStart;
+    if (destStart < 0) return destStart;
+    if (myFstat(file->src, &src_meta_data) != 0) return -EBADF;
+
+    off_t end = src_meta_data.st_size;
+    if (len >= 0 && srcStart + len < end) end = srcStart + len;
+
+    if (uringInit(&ring, depth) != 0) return -EOPNOTSUPP;
+
+    //Allocates one buffer per request in flight and registers them with the kernel
+    char* bufs = myMmap(NULL, (size_t) depth * URING_BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufs == MAP_FAILED) {
+        uringExit(&ring);
+        return -ENOMEM;
+    }
+    for (int i = 0; i < depth; i++) {
+        slots[i].buf = bufs + (size_t) i * URING_BUF_SIZE;
+        slots[i].state = SLOT_IDLE;
+        slots[i].inFlight = false;
+        iovecs[i].iov_base = slots[i].buf;
+        iovecs[i].iov_len = URING_BUF_SIZE;
+    }
+    if (myIoUringRegister(ring.fd, IORING_REGISTER_BUFFERS, iovecs, depth) != 0) {
+        uringExit(&ring);
+        myMunmap(bufs, (size_t) depth * URING_BUF_SIZE);
+        return -EOPNOTSUPP;
+    }
+
+    off_t nextRead = srcStart;
+    long total = 0;
+    long error = 0;
+    int inFlight = 0;
+    unsigned int queued = 0;
+    bool active = true;
+
+    while (active) {
+        //Queues a request for every buffer that is not waiting on one, after any the kernel has not yet taken
+        unsigned int tail = *ring.sqTail;
+        unsigned int toSubmit = queued;
+        active = false;
+        for (int i = 0; i < depth; i++) {
+            struct uringSlot* slot = &slots[i];
+
+            //Starts reading the next chunk of src into an idle buffer
+            if (slot->state == SLOT_IDLE && nextRead < end && error == 0) {
+                slot->state = SLOT_READING;
+                slot->offset = nextRead;
+                slot->len = (end - nextRead > URING_BUF_SIZE) ? URING_BUF_SIZE : (size_t) (end - nextRead);
+                slot->done = 0;
+                nextRead += slot->len;
+            }
+
+            //After an error, buffers are abandoned rather than requeued
+            if (slot->state != SLOT_IDLE && !slot->inFlight && error != 0) slot->state = SLOT_IDLE;
+            if (slot->state == SLOT_IDLE) continue;
+            active = true;
+            if (slot->inFlight) continue;
+
+            unsigned int index = tail & *ring.sqMask;
+            struct io_uring_sqe* sqe = &ring.sqes[index];
+
+            //Zeroes the entry before filling it in
+            char* sqeBytes = (char*) sqe;
+            for (unsigned int j = 0; j < sizeof(*sqe); j++) sqeBytes[j] = 0;
+
+            //Reads the rest of the chunk, or writes it to the same offset in dest
+            if (slot->state == SLOT_READING) {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->fd = file->src;
+                sqe->off = slot->offset + slot->done;
+            } else {
+                sqe->opcode = IORING_OP_WRITE_FIXED;
+                sqe->fd = file->dest;
+                sqe->off = destStart + (slot->offset - srcStart) + slot->done;
+            }
+            sqe->addr = (unsigned long) (slot->buf + slot->done);
+            sqe->len = slot->len - slot->done;
+            sqe->buf_index = i;
+            sqe->user_data = i;
+            ring.sqArray[index] = index;
+
+            slot->inFlight = true;
+            tail++;
+            toSubmit++;
+        }
+        if (!active) break;
+
+        //Makes the new entries visible to the kernel before submitting them
+        __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+
+        //Submits the new requests and waits until at least one has completed
+        int ret = myIoUringEnter(ring.fd, toSubmit, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && ret != -EINTR) {
+            error = ret;
+            break;
+        }
+
+        /*The kernel may take fewer entries than were queued (e.g. when short of
+        memory), leaving the rest in the queue to be submitted next time*/
+        if (ret < 0) ret = 0;
+        inFlight += ret;
+        queued = toSubmit - ret;
+
+        //Reaps every completion that is available
+        unsigned int head = *ring.cqHead;
+        while (head != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+            struct uringSlot* slot = &slots[cqe->user_data];
+            int res = cqe->res;
+            slot->inFlight = false;
+            head++;
+            inFlight--;
+
+            //Interrupted requests are queued again as they were
+            if (res == -EINTR || res == -EAGAIN) continue;
+            if (res < 0) {
+                if (error == 0) error = res;
+                slot->state = SLOT_IDLE;
+                continue;
+            }
+
+            if (slot->state == SLOT_READING) {
+                slot->done += res;
+
+                //src was truncated while copying, so stops reading at its new end
+                if (res == 0) {
+                    slot->len = slot->done;
+                    if (slot->offset + (off_t) slot->done < end) end = slot->offset + slot->done;
+                }
+
+                //Once the chunk has been read, writes it
+                if (slot->done == slot->len) {
+                    slot->state = (slot->len > 0) ? SLOT_WRITING : SLOT_IDLE;
+                    slot->done = 0;
+                }
+            } else {
+                slot->done += res;
+                if (slot->done == slot->len) {
+                    total += slot->len;
+                    slot->state = SLOT_IDLE;
+                }
+            }
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    /*Closing the ring does not wait for requests still in flight, which could
+    then write to dest after returning, so waits for them first*/
+    uringDrain(&ring, inFlight);
+    uringExit(&ring);
+    myMunmap(bufs, (size_t) depth * URING_BUF_SIZE);
+    if (error != 0) return error;
+
+    //Moves the file offsets past the data copied, as the other engines do
+    myLseek(file->src, srcStart + total, SEEK_SET);
+    myLseek(file->dest, destStart + total, SEEK_SET);
+    return total;
+}
+
+/**
+Sets up an io_uring and maps its submission and completion queues. Checks that
+the kernel supports reads and writes with fixed buffers so that callers can
+fall back otherwise.
+@ring - struct to store queue pointers in
+@entries - number of entries in the submission queue
+@return - 0 if successful, negative error number otherwise
+**/
+int uringInit(struct uringQueue* ring, unsigned int entries) {
+    struct io_uring_params params;
+    char* paramBytes = (char*) &params;
+    for (unsigned int i = 0; i < sizeof(params); i++) paramBytes[i] = 0;
+
+    ring->fd = myIoUringSetup(entries, &params);
+    if (ring->fd < 0) return ring->fd;
+
+    //Checks the kernel supports fixed buffer reads and writes
+    struct {
+        struct io_uring_probe probe;
+        struct io_uring_probe_op ops[IORING_OP_LAST];
+    } probe;
+    char* probeBytes = (char*) &probe;
+    for (unsigned int i = 0; i < sizeof(probe); i++) probeBytes[i] = 0;
+
+    int status = myIoUringRegister(ring->fd, IORING_REGISTER_PROBE, &probe, IORING_OP_LAST);
+    if (status != 0 || !(probe.ops[IORING_OP_READ_FIXED].flags & IO_URING_OP_SUPPORTED)
+            || !(probe.ops[IORING_OP_WRITE_FIXED].flags & IO_URING_OP_SUPPORTED)) {
+        myClose(ring->fd);
+        return -EOPNOTSUPP;
+    }
+
+    //Maps the submission queue ring, completion queue ring and submission queue entries
+    ring->sqEntries = params.sq_entries;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sqRing = myMmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cqRing = myMmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = myMmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        if (ring->sqRing != MAP_FAILED) myMunmap(ring->sqRing, ring->sqRingSize);
+        if (ring->cqRing != MAP_FAILED) myMunmap(ring->cqRing, ring->cqRingSize);
+        if (ring->sqes != MAP_FAILED) myMunmap(ring->sqes, ring->sqesSize);
+        myClose(ring->fd);
+        return -ENOMEM;
+    }
+
+    char* sq = ring->sqRing;
+    char* cq = ring->cqRing;
+    ring->sqHead = (unsigned int*) (sq + params.sq_off.head);
+    ring->sqTail = (unsigned int*) (sq + params.sq_off.tail);
+    ring->sqMask = (unsigned int*) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned int*) (sq + params.sq_off.array);
+    ring->cqHead = (unsigned int*) (cq + params.cq_off.head);
+    ring->cqTail = (unsigned int*) (cq + params.cq_off.tail);
+    ring->cqMask = (unsigned int*) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+/**
+Unmaps the queues of an io_uring and closes it
+@ring - io_uring set up by uringInit
+**/
+void uringExit(struct uringQueue* ring) {
+    myMunmap(ring->sqRing, ring->sqRingSize);
+    myMunmap(ring->cqRing, ring->cqRingSize);
+    myMunmap(ring->sqes, ring->sqesSize);
+    myClose(ring->fd);
+}
+
+/**
+Waits for requests submitted to an io_uring to complete, discarding their
+results, so that the ring can be closed without them still running
+@ring - io_uring set up by uringInit
+@inFlight - number of requests submitted but not yet reaped
+**/
+void uringDrain(struct uringQueue* ring, int inFlight) {
+    while (inFlight > 0) {
+        int ret = myIoUringEnter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && ret != -EINTR) return;
+
+        unsigned int head = *ring->cqHead;
+        while (head != __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+            head++;
+            inFlight--;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+Writes count bytes from buf to fd. write may write fewer bytes than asked (e.g.
+when interrupted by a signal), so it is called until everything is written.
+@fd - fd to write to
+@buf - buffer to write from
+@count - number of bytes to write
+@return - count if successful, negative error number otherwise
+**/
+long writeAll(int fd, char* buf, size_t count) {
+    size_t written = 0;
+
+    while (written < count) {
+        long ret = myWrite(fd, buf + written, count - written);
+        if (ret == -EINTR) continue;
+        if (ret < 0) return ret;
+        if (ret == 0) return -EIO;
+        written += ret;
+    }
+
+    return count;
+}
+
+/**
+Sets up the state used to copy src to dest. The size of the read/write buffer
+is chosen here but the buffer is only allocated if the engine is used.
+@file - struct to set up
+@dest - fd of destination file
+@src - fd of source file
+@src_meta_data - meta data of source file
+**/
+void initCopyFile(struct copyFile* file, int dest, int src, struct stat* src_meta_data) {
+    struct stat dest_meta_data;
+    file->dest = dest;
+    file->src = src;
+    file->buf = NULL;
+    file->stream = !S_ISREG(src_meta_data->st_mode);
+    file->crc = 0;
+    file->crcLen = 0;
+
+    if (myFstat(dest, &dest_meta_data) != 0) dest_meta_data.st_blksize = PAGE_SIZE;
+    file->bufSize = chooseBufferSize(src_meta_data, &dest_meta_data);
+}
+
+/**
+Frees the buffer of a copyFile if it was allocated. Does not close the files.
+@file - file that has been copied
+**/
+void freeCopyFile(struct copyFile* file) {
+    if (file->buf != NULL) myMunmap(file->buf, file->bufSize);
+    file->buf = NULL;
+}
+
+/**
+Picks the size of the buffer used by the read/write engine. Starts from the
+larger of the two files' preferred I/O block sizes, then grows to fit the whole
+source, between MIN_COPY_BUF_SIZE and MAX_COPY_BUF_SIZE. The size is a
+multiple of the page size and of the block size.
+@src_meta_data - meta data of source file
+@dest_meta_data - meta data of destination file
+@return - size of buffer in bytes
+**/
+size_t chooseBufferSize(struct stat* src_meta_data, struct stat* dest_meta_data) {
+    size_t blockSize = src_meta_data->st_blksize > dest_meta_data->st_blksize
+                       ? src_meta_data->st_blksize : dest_meta_data->st_blksize;
+    if (blockSize < PAGE_SIZE) blockSize = PAGE_SIZE;
+
+    //Uses the default size for files of unknown size such as pipes
+    size_t size = S_ISREG(src_meta_data->st_mode) ? (size_t) src_meta_data->st_size : DEFAULT_COPY_BUF_SIZE;
+    if (size < MIN_COPY_BUF_SIZE) size = MIN_COPY_BUF_SIZE;
+    if (size > MAX_COPY_BUF_SIZE) size = MAX_COPY_BUF_SIZE;
+    if (size < blockSize) size = blockSize;
+
+    //Rounds up to a whole number of blocks
+    return (size + blockSize - 1) / blockSize * blockSize;
+}
+
+/**
+Copies a sparse file by walking its data regions with lseek SEEK_DATA and
+SEEK_HOLE. Only data regions are read and written, at the same offsets in dest,
+so holes are left unallocated in dest. dest must be empty. Finally dest is
+extended to the size of src with ftruncate, recreating any hole at the end.
+@file - file being copied, dest must be empty
+@size - size of source file
+@return - number of data bytes copied, or negative error number if src cannot
+be searched for holes (e.g. EINVAL if unsupported by the filesystem)
+**/
+long sparseCopy(struct copyFile* file, off_t size) {
+    long total = 0;
+    off_t data = 0;
+
+    while (data < size) {
+        //Finds the start of the next data region, ENXIO meaning only a hole remains
+        data = myLseek(file->src, data, SEEK_DATA);
+        if (data == -ENXIO) break;
+        if (data < 0) return data;
+
+        //Finds the end of the data region
+        off_t hole = myLseek(file->src, data, SEEK_HOLE);
+        if (hole < 0) return hole;
+
+        //Copies the data region to the same offset in dest
+        myLseek(file->src, data, SEEK_SET);
+        myLseek(file->dest, data, SEEK_SET);
+        long ret = writeToFile(file, hole - data);
+        if (ret < 0) return ret;
+
+        total += ret;
+        data = hole;
+    }
+
+    //Sets the size of dest, leaving the final hole unallocated
+    int status = myFtruncate(file->dest, size);
+    if (status < 0) return status;
+
+    return total;
+}
+
+/**
+Copies src over an existing dest by reading both into buffers and comparing
+them in chunks of DELTA_CHUNK_SIZE. Only chunks that differ are written, with
+neighbouring differing chunks written together, so a mostly unchanged dest is
+mostly only read. Part of src beyond the end of dest always differs. Finally
+dest is truncated to the size of src. The file offsets are not changed.
+@file - file being copied, dest may hold an older copy of src
+@size - size of source file
+@return - number of bytes written to dest, or negative error number
+**/
+long deltaCopy(struct copyFile* file, off_t size) {
+    long written = 0;
+    off_t offset = 0;
+
+    //The buffer of the copyFile holds src, a second buffer of the same size holds dest
+    if (allocCopyBuffer(file) != 0) return -ENOMEM;
+    char* destBuf = myMmap(NULL, file->bufSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (destBuf == MAP_FAILED) return -ENOMEM;
+
+    while (offset < size) {
+        size_t count = (size - offset > (off_t) file->bufSize) ? file->bufSize : (size_t) (size - offset);
+        long srcRead = readFullAt(file->src, file->buf, count, offset);
+        if (srcRead <= 0) {
+            written = srcRead;
+            break;
+        }
+        long destRead = readFullAt(file->dest, destBuf, srcRead, offset);
+        if (destRead < 0) {
+            written = destRead;
+            break;
+        }
+        addChecksum(file, file->buf, srcRead);
+
+        /*Finds each run of differing chunks and writes it with one call. The
+        last iteration starts at the end of the data to write out the last run*/
+        long runStart = -1;
+        for (long chunk = 0; chunk < srcRead || runStart >= 0; chunk += DELTA_CHUNK_SIZE) {
+            if (chunk > srcRead) chunk = srcRead;
+            long len = (srcRead - chunk > DELTA_CHUNK_SIZE) ? DELTA_CHUNK_SIZE : srcRead - chunk;
+            bool differs = (len > 0) && (chunk + len > destRead || !chunksEqual(file->buf + chunk, destBuf + chunk, len));
+
+            if (differs && runStart < 0) runStart = chunk;
+            if (!differs && runStart >= 0) {
+                for (long done = runStart; done < chunk; ) {
+                    long ret = myPwrite(file->dest, file->buf + done, chunk - done, offset + done);
+                    if (ret == -EINTR) continue;
+                    if (ret <= 0) {
+                        myMunmap(destBuf, file->bufSize);
+                        return (ret < 0) ? ret : -EIO;
+                    }
+                    done += ret;
+                }
+                written += chunk - runStart;
+                runStart = -1;
+            }
+        }
+
+        offset += srcRead;
+    }
+
+    myMunmap(destBuf, file->bufSize);
+    if (written < 0) return written;
+
+    //Removes any part of dest beyond the end of src
+    int status = myFtruncate(file->dest, offset);
+    if (status < 0) return status;
+
+    return written;
+}
+
+/**
+Compares two buffers. With SSE2 64 bytes are compared per iteration by XORing
+four pairs of 16 byte vectors and checking the OR of the results is zero, which
+keeps comparing as fast as reading the files. The remaining bytes, or all of
+them without SSE2, are compared a word and then a byte at a time.
+@a - first buffer
+@b - second buffer
+@len - number of bytes to compare
+@return - whether the buffers are equal
+**/
+bool chunksEqual(const char* a, const char* b, size_t len) {
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 64 <= len; i += 64) {
+        const __m128i* va = (const __m128i*) (a + i);
+        const __m128i* vb = (const __m128i*) (b + i);
+        __m128i diff = _mm_or_si128(
+            _mm_or_si128(_mm_xor_si128(_mm_loadu_si128(va), _mm_loadu_si128(vb)),
+                         _mm_xor_si128(_mm_loadu_si128(va + 1), _mm_loadu_si128(vb + 1))),
+            _mm_or_si128(_mm_xor_si128(_mm_loadu_si128(va + 2), _mm_loadu_si128(vb + 2)),
+                         _mm_xor_si128(_mm_loadu_si128(va + 3), _mm_loadu_si128(vb + 3))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero)) != 0xFFFF) return false;
+    }
+#endif
+
+    for (; i + sizeof(unsigned long) <= len; i += sizeof(unsigned long)) {
+        if (*(const unsigned long*) (a + i) != *(const unsigned long*) (b + i)) return false;
+    }
+    for (; i < len; i++) {
+        if (a[i] != b[i]) return false;
+    }
+
+    return true;
+}
+
+/**
+Reads count bytes at an offset of a file, retrying short and interrupted reads
+@fd - file to read from
+@buf - buffer to read into
+@count - number of bytes to read
+@offset - offset in file to read from
+@return - number of bytes read, less than count only at end of file, or negative error number
+**/
+long readFullAt(int fd, char* buf, size_t count, off_t offset) {
+    size_t total = 0;
+
+    while (total < count) {
+        long ret = myPread(fd, buf + total, count - total, offset + total);
+        if (ret == -EINTR) continue;
+        if (ret < 0) return ret;
+        if (ret == 0) break;
+        total += ret;
+    }
+
+    return total;
+}
+
+/**
+Checks that a copy holds the same data as its source by comparing CRC32C
+checksums. The checksum of the source is the one computed as the data passed
+through the copy buffer, or if an engine copied it inside the kernel the
+source is read again. The destination is then read again from the start.
+@file - file that has been copied
+@size - number of bytes copied
+@return - 0 if the checksums match, ERRVERIFY if they do not, or ERRCOPY with
+the errno of a read that failed
+**/
+int verifyCopy(struct copyFile* file, off_t size) {
+    unsigned int srcCrc = file->crc;
+    unsigned int destCrc;
+    long ret;
+
+    if (file->crcLen != size) {
+        //Streams are always copied through the buffer, so cannot be missing a checksum
+        if (file->stream) return ERRVERIFY;
+        ret = checksumFile(file, file->src, size, &srcCrc);
+        if (ret < 0) return errorWithErrno(ERRCOPY, -ret);
+        if (ret != size) return ERRVERIFY;
+    }
+
+    ret = checksumFile(file, file->dest, size, &destCrc);
+    if (ret < 0) return errorWithErrno(ERRCOPY, -ret);
+
+    return (ret == size && srcCrc == destCrc) ? 0 : ERRVERIFY;
+}
+
+/**
+Computes the CRC32C checksum of the start of a file, reading it through the
+buffer of a copyFile with pread so that its offset is not changed
+@file - file being copied, whose buffer is used
+@fd - file to read
+@size - number of bytes to read from the start of fd
+@crc - set to the checksum of the bytes read
+@return - number of bytes read, less than size if fd is shorter, or negative error number
+**/
+long checksumFile(struct copyFile* file, int fd, off_t size, unsigned int* crc) {
+    off_t offset = 0;
+
+    if (allocCopyBuffer(file) != 0) return -ENOMEM;
+
+    *crc = 0;
+    while (offset < size) {
+        size_t count = (size - offset > (off_t) file->bufSize) ? file->bufSize : (size_t) (size - offset);
+        long ret = readFullAt(fd, file->buf, count, offset);
+        if (ret < 0) return ret;
+        if (ret == 0) break;
+
+        *crc = crc32c(*crc, file->buf, ret);
+        offset += ret;
+    }
+
+    return offset;
+}
+
+/**
+Adds data that has been copied to the checksum of a copyFile if --verify was
+given. Data must be added in order from the start of src.
+@file - file being copied
+@buf - data that was copied
+@len - number of bytes copied
+**/
+void addChecksum(struct copyFile* file, const char* buf, size_t len) {
+    if (!options.verify) return;
+
+    file->crc = crc32c(file->crc, buf, len);
+    file->crcLen += len;
+}
+
+/**
+Computes the CRC32C checksum of a buffer, continuing from the checksum of the
+data before it (0 to start)
+@crc - checksum of the preceding data
+@buf - data to add to checksum
+@len - number of bytes in buf
+@return - checksum of the preceding data followed by buf
+**/
+unsigned int crc32c(unsigned int crc, const char* buf, size_t len) {
+    pthread_once(&crcOnce, crc32cInit);
+
+    //The checksum is kept inverted while it is computed
+    crc = ~crc;
+    crc = crcHardware ? crc32cHardware(crc, buf, len) : crc32cTable(crc, buf, len);
+    return ~crc;
+}
+
+/**
+Checks with cpuid whether the CPU has the crc32 instruction (SSE4.2, bit 20 of
+ecx for leaf 1) and fills the lookup table used if it does not
+**/
+void crc32cInit() {
+    unsigned int features = 0;
+
+    asm( "movl $1, %%eax\n\t"
+         "xorl %%ecx, %%ecx\n\t"
+         "cpuid\n\t"
+         "movl %%ecx, %0\n\t" :
+         "=r"(features) :
+         :
+         "%rax","%rbx","%rcx","%rdx" );
+    crcHardware = (features >> 20) & 1;
+
+    //Each entry is the remainder of a byte, so the table can process a byte at a time
+    for (unsigned int i = 0; i < 256; i++) {
+        unsigned int crc = i;
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+        crcTable[i] = crc;
+    }
+}
+
+/**
+Computes CRC32C with the crc32 instruction of SSE4.2, 8 bytes at a time once
+buf is aligned. The instruction is written in assembly so that mycp can be
+compiled without -msse4.2 and still run on CPUs without it.
+@crc - inverted checksum of the preceding data
+@buf - data to add to checksum
+@len - number of bytes in buf
+@return - inverted checksum
+**/
+unsigned int crc32cHardware(unsigned int crc, const char* buf, size_t len) {
+    unsigned long crc64;
+
+    while (len > 0 && ((unsigned long) buf & 7) != 0) {
+        asm( "crc32b %1, %0" : "+r"(crc) : "rm"(*(const unsigned char*) buf) );
+        buf++;
+        len--;
+    }
+
+    crc64 = crc;
+    for (; len >= 8; len -= 8, buf += 8) {
+        asm( "crc32q %1, %0" : "+r"(crc64) : "rm"(*(const unsigned long*) buf) );
+    }
+    crc = crc64;
+
+    for (; len > 0; len--, buf++) {
+        asm( "crc32b %1, %0" : "+r"(crc) : "rm"(*(const unsigned char*) buf) );
+    }
+
+    return crc;
+}
+
+/**
+Computes CRC32C a byte at a time with a lookup table, for CPUs without SSE4.2
+@crc - inverted checksum of the preceding data
+@buf - data to add to checksum
+@len - number of bytes in buf
+@return - inverted checksum
+**/
+unsigned int crc32cTable(unsigned int crc, const char* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc = crcTable[(crc ^ (unsigned char) buf[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+/**
+Custom wrapper function for stat system call using inline assembly
+@fileName - name of file to get meta data about
+@meta_data - struct to store file meta data in
+@return - status code
+**/
+int myStat(char* fileName, struct stat* meta_data) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)STAT_SYSCALL), "r"(fileName), "r"(meta_data) :
+         "%rax","%rdi", "%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for open system call using inline assembly
+@fileName - name of file to open
+@mode - access mode of file
+@return - file descriptor if successful, -1 if error occurred
+**/
+int myOpen(char* fileName, mode_t mode) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)OPEN_SYSCALL), "r"(fileName), "r"((long)mode) :
+         "%rax","%rdi", "%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for close system call using inline assembly
+@fd - file descriptor of file to close
+@return - 0 if successful, -1 if error and errno is set
+**/
+int myClose(long fd) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)CLOSE_SYSCALL), "r"(fd) :
+         "%rax","%rdi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for write system call using inline assembly
+@fd - stream to write to
+@buf - to write from
+@count - size to write
+**/
+int myWrite(int fd, const void* buf, size_t count) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)WRITE_SYSCALL),"r"((long)fd), "r"(buf), "r"(count) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for creat system call using inline assembly
+@pathname - path of file to create
+@mode - access mode of file
+@return - file descriptor if successful, -1 if error occurred
+**/
+int myCreat(const char* pathname, mode_t mode) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)CREAT_SYSCALL), "r"(pathname), "r"((long)mode) :
+         "%rax","%rdi", "%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for mkdir system call using inline assembly
+@pathname - path of directory to create
+@mode - access mode of directory
+@return - file descriptor if successful, -1 if error occurred
+**/
+int mymkdir(const char* pathname, mode_t mode) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)MKDIR_SYSCALL), "r"(pathname), "r"((long)mode) :
+         "%rax","%rdi", "%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for openat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of file to open
+@flags - O_* flags
+@mode - access mode if the file is created
+@return - file descriptor if successful, negative error number otherwise
+**/
+int myOpenat(int dirfd, const char* pathname, int flags, mode_t mode) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)OPENAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"((long)flags), "r"((long)mode) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for mkdirat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of directory to create
+@mode - access mode of directory
+@return - status code
+**/
+int myMkdirat(int dirfd, const char* pathname, mode_t mode) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)MKDIRAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"((long)mode) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for newfstatat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of file to get meta data about
+@meta_data - struct to store file meta data in
+@flags - AT_* flags, e.g. AT_SYMLINK_NOFOLLOW
+@return - status code
+**/
+int myFstatat(int dirfd, const char* pathname, struct stat* meta_data, int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)NEWFSTATAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"(meta_data), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for fchmodat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of file to change
+@mode - new access mode
+@return - status code
+**/
+int myFchmodat(int dirfd, const char* pathname, mode_t mode) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)FCHMODAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"((long)mode) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for mknodat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of file to create
+@mode - type and access mode of file, e.g. S_IFIFO | 0644
+@dev - device number if the file is a device
+@return - status code
+**/
+int myMknodat(int dirfd, const char* pathname, mode_t mode, dev_t dev) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)MKNODAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"((long)mode), "r"((long)dev) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for unlinkat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of file to remove
+@flags - AT_REMOVEDIR to remove a directory, otherwise 0
+@return - status code
+**/
+int myUnlinkat(int dirfd, const char* pathname, int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)UNLINKAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for symlinkat system call using inline assembly
+@target - path the link points to
+@dirfd - directory linkpath is relative to, or AT_FDCWD
+@linkpath - path of link to create
+@return - status code
+**/
+int mySymlinkat(const char* target, int dirfd, const char* linkpath) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)SYMLINKAT_SYSCALL), "r"(target), "r"((long)dirfd), "r"(linkpath) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for readlinkat system call using inline assembly
+@dirfd - directory pathname is relative to, or AT_FDCWD
+@pathname - path of symlink to read
+@buf - buffer to store target in, which is not null terminated
+@size - size of buf
+@return - length of target, or negative error number
+**/
+long myReadlinkat(int dirfd, const char* pathname, char* buf, size_t size) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)READLINKAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"(buf), "r"(size) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for utimensat system call using inline assembly
+@dirfd - directory pathname is relative to, or the file itself if pathname is NULL
+@pathname - path of file to change, or NULL
+@times - new access and modification times, or NULL for the current time
+@flags - AT_* flags
+@return - status code
+**/
+int myUtimensat(int dirfd, const char* pathname, const struct timespec times[2], int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)UTIMENSAT_SYSCALL), "r"((long)dirfd), "r"(pathname), "r"(times), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for unlink system call using inline assembly
+@pathname - path of file to delete
+@return - result of deletion
+**/
+int myUnlink(const char* pathname) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)UNLINK_SYSCALL), "r"(pathname) :
+         "%rax","%rdi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for rmdir system call using inline assembly
+@pathname - path of directory to delete
+@return - result of deletion
+**/
+int myrmdir(const char* pathname) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)RMDIR_SYSCALL), "r"(pathname) :
+         "%rax","%rdi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for read system call using inline assembly
+@pathname - path of directory to delete
+@return - result of deletion
+**/
+int myRead(int fd, void* buf, size_t count) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)READ_SYSCALL), "r"((long)fd), "r"(buf), "r"(count) :
+         "%rax","%rdi", "%rsi", "%rdx", "%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for truncate system call using inline assembly
+@path - path of file to truncate
+@length - length to truncate file to
+**/
+int myTruncate(const char* path, off_t length) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)TRUNCATE_SYSCALL), "r"(path), "r"((long)length) :
+         "%rax","%rdi", "%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for copy_file_range system call using inline assembly
+@fdIn - fd of file to copy from
+@offIn - offset to copy from, or NULL to use and advance the file offset of fdIn
+@fdOut - fd of file to copy to
+@offOut - offset to copy to, or NULL to use and advance the file offset of fdOut
+@len - maximum number of bytes to copy
+@flags - must be 0
+@return - number of bytes copied, 0 at end of file, or negative error number
+**/
+long myCopyFileRange(int fdIn, loff_t* offIn, int fdOut, loff_t* offOut, size_t len, unsigned int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq %6, %%r8\n\t"
+         "movq %7, %%r9\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "g"((long)COPY_FILE_RANGE_SYSCALL), "g"((long)fdIn), "g"(offIn), "g"((long)fdOut),
+         "g"(offOut), "g"(len), "g"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%r9","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for ioctl system call using inline assembly
+@fd - fd of file to operate on
+@request - device dependent request code
+@arg - argument of request
+@return - status code
+**/
+int myIoctl(int fd, unsigned long request, unsigned long arg) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IOCTL_SYSCALL), "r"((long)fd), "r"(request), "r"(arg) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for lseek system call using inline assembly
+@fd - fd of file to reposition
+@offset - offset relative to whence
+@whence - SEEK_SET, SEEK_CUR, SEEK_END, SEEK_DATA or SEEK_HOLE
+@return - resulting offset, or negative error number
+**/
+off_t myLseek(int fd, off_t offset, int whence) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)LSEEK_SYSCALL), "r"((long)fd), "r"((long)offset), "r"((long)whence) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for ftruncate system call using inline assembly
+@fd - fd of file to truncate
+@length - length to truncate or extend file to
+@return - status code
+**/
+int myFtruncate(int fd, off_t length) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)FTRUNCATE_SYSCALL), "r"((long)fd), "r"((long)length) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for fstat system call using inline assembly
+@fd - fd of file to get meta data about
+@meta_data - struct to store file meta data in
+@return - status code
+**/
+int myFstat(int fd, struct stat* meta_data) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)FSTAT_SYSCALL), "r"((long)fd), "r"(meta_data) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for fallocate system call using inline assembly
+@fd - fd of file to allocate space for
+@mode - FALLOC_FL_* flags, 0 to allocate and extend the file
+@offset - offset of range to allocate
+@len - length of range to allocate
+@return - status code
+**/
+int myFallocate(int fd, int mode, off_t offset, off_t len) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)FALLOCATE_SYSCALL), "r"((long)fd), "r"((long)mode), "r"((long)offset), "r"((long)len) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for splice system call using inline assembly
+@fdIn - fd to move data from
+@offIn - offset to read from, or NULL to use and advance the file offset of fdIn
+@fdOut - fd to move data to
+@offOut - offset to write to, or NULL to use and advance the file offset of fdOut
+@len - maximum number of bytes to move
+@flags - SPLICE_F_* flags
+@return - number of bytes moved, 0 at end of input, or negative error number
+**/
+long mySplice(int fdIn, loff_t* offIn, int fdOut, loff_t* offOut, size_t len, unsigned int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq %6, %%r8\n\t"
+         "movq %7, %%r9\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "g"((long)SPLICE_SYSCALL), "g"((long)fdIn), "g"(offIn), "g"((long)fdOut),
+         "g"(offOut), "g"(len), "g"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%r9","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for sendfile system call using inline assembly
+@outFd - fd to write to
+@inFd - fd to read from
+@offset - offset to read from, or NULL to use and advance the file offset of inFd
+@count - maximum number of bytes to copy
+@return - number of bytes copied, 0 at end of file, or negative error number
+**/
+long mySendfile(int outFd, int inFd, off_t* offset, size_t count) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)SENDFILE_SYSCALL), "r"((long)outFd), "r"((long)inFd), "r"(offset), "r"(count) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for pipe2 system call using inline assembly
+@fds - filled with the read end then the write end of the pipe
+@flags - O_CLOEXEC, O_NONBLOCK or 0
+@return - status code
+**/
+int myPipe2(int fds[2], int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)PIPE2_SYSCALL), "r"(fds), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for fcntl system call using inline assembly
+@fd - fd to operate on
+@cmd - F_* command
+@arg - argument of command
+@return - result of command, or negative error number
+**/
+int myFcntl(int fd, int cmd, long arg) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)FCNTL_SYSCALL), "r"((long)fd), "r"((long)cmd), "r"(arg) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for io_uring_setup system call using inline assembly
+@entries - number of entries requested for the submission queue
+@params - parameters of the io_uring, filled in with ring offsets by the kernel
+@return - file descriptor of io_uring if successful, negative error number otherwise
+**/
+int myIoUringSetup(unsigned int entries, struct io_uring_params* params) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IO_URING_SETUP_SYSCALL), "r"((long)entries), "r"(params) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for io_uring_enter system call using inline assembly
+@fd - file descriptor of io_uring
+@toSubmit - number of new submission queue entries to submit
+@minComplete - number of completions to wait for if IORING_ENTER_GETEVENTS is set
+@flags - IORING_ENTER_* flags
+@return - number of entries submitted, or negative error number
+**/
+int myIoUringEnter(long fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq $0, %%r8\n\t"
+         "movq $0, %%r9\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IO_URING_ENTER_SYSCALL), "r"(fd), "r"((long)toSubmit),
+         "r"((long)minComplete), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%r9","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for io_uring_register system call using inline assembly
+@fd - file descriptor of io_uring
+@opcode - IORING_REGISTER_* operation
+@arg - argument of operation
+@numArgs - number of elements in arg
+@return - status code
+**/
+int myIoUringRegister(long fd, unsigned int opcode, void* arg, unsigned int numArgs) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IO_URING_REGISTER_SYSCALL), "r"(fd), "r"((long)opcode), "r"(arg), "r"((long)numArgs) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for statx system call using inline assembly.
+Only the fields in mask are guaranteed to be filled in.
+@dirfd - file descriptor of directory fileName is relative to, or of the file
+itself if fileName is "" and flags has AT_EMPTY_PATH
+@fileName - name of file to get meta data about
+@flags - AT_* flags
+@mask - STATX_* fields to request
+@meta_data - struct to store file meta data in
+@return - status code
+**/
+int myStatx(long dirfd, char* fileName, int flags, unsigned int mask, struct statx* meta_data) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq %6, %%r8\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)STATX_SYSCALL), "r"(dirfd), "r"(fileName), "r"((long)flags),
+         "r"((long)mask), "r"(meta_data) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for fadvise64 system call using inline assembly
+@fd - file to advise about
+@offset - start of range
+@len - length of range, 0 for the rest of the file
+@advice - POSIX_FADV_* expected access pattern
+@return - status code
+**/
+int myFadvise(int fd, off_t offset, off_t len, int advice) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)FADVISE64_SYSCALL), "r"((long)fd), "r"((long)offset), "r"((long)len), "r"((long)advice) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for sync_file_range system call using inline assembly
+@fd - file to write back
+@offset - start of range
+@nbytes - length of range, 0 for the rest of the file
+@flags - SYNC_FILE_RANGE_* flags choosing whether to start and wait for writeback
+@return - status code
+**/
+int mySyncFileRange(int fd, off_t offset, off_t nbytes, unsigned int flags) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)SYNC_FILE_RANGE_SYSCALL), "r"((long)fd), "r"((long)offset), "r"((long)nbytes), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for getdents64 system call using inline assembly
+@fd - file descriptor of file to get directory entries
+@buf - buffer to store directory entry data in
+@bufferSize - size of buffer
+@return - number of bytes read
+**/
+int myGetDents(long fd, char* buf, unsigned long bufferSize) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)GETDENTS64_SYSCALL), "r"(fd), "r"(buf), "r"(bufferSize) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for pread64 system call using inline assembly
+@fd - file to read from
+@buf - buffer to read into
+@count - maximum number of bytes to read
+@offset - offset in file to read from, the file offset is not changed
+@return - number of bytes read, 0 at end of file, or negative error number
+**/
+long myPread(int fd, void* buf, size_t count, off_t offset) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)PREAD64_SYSCALL), "r"((long)fd), "r"(buf), "r"(count), "r"((long)offset) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for pwrite64 system call using inline assembly
+@fd - file to write to
+@buf - buffer to write from
+@count - number of bytes to write
+@offset - offset in file to write at, the file offset is not changed
+@return - number of bytes written, or negative error number
+**/
+long myPwrite(int fd, const void* buf, size_t count, off_t offset) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)PWRITE64_SYSCALL), "r"((long)fd), "r"(buf), "r"(count), "r"((long)offset) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for madvise system call using inline assembly
+@addr - start of mapped range, page aligned
+@length - length of range
+@advice - MADV_* expected access pattern
+@return - status code
+**/
+int myMadvise(void* addr, size_t length, int advice) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)MADVISE_SYSCALL), "r"(addr), "r"(length), "r"((long)advice) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for mmap system call using inline assembly
+@addr - hint for address of mapping, or NULL
+@length - length of mapping in bytes
+@prot - memory protection of mapping
+@flags - type of mapping
+@fd - file to map, -1 for anonymous mappings
+@offset - offset into file to map from
+@return - address of mapping, or MAP_FAILED if error occurred
+**/
+void* myMmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq %6, %%r8\n\t"
+         "movq %7, %%r9\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "g"((long)MMAP_SYSCALL), "g"(addr), "g"(length), "g"((long)prot),
+         "g"((long)flags), "g"((long)fd), "g"((long)offset) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%r9","%rcx","%r11","memory" );
+
+    //Errors are returned as a negative error number in the range -4095 to -1
+    if (ret < 0 && ret > -4096) return MAP_FAILED;
+    return (void*) ret;
+}
+
+/**
+Custom wrapper function for munmap system call using inline assembly
+@addr - address of mapping to remove
+@length - length of mapping in bytes
+@return - 0 if successful, negative error number otherwise
+**/
+int myMunmap(void* addr, size_t length) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)MUNMAP_SYSCALL), "r"(addr), "r"(length) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom implementation of strlen function
+@str - string to get the length of
+@return - length of string not including '\0'
+**/
+int myStrLen(char* str) {
+    if (str == NULL) return -1;
+
+    int i;
+    for (i = 0; str[i] != '\0'; i++);
+    return i;
+}
+
+/**
+Custom implementation of strcpy function
+@dest - destination to copy string to
+@src - source to copy string from
+@n - size of string to copy in bytes
+**/
+void myStrCpy(char* dest, const char* src, size_t n) {
+    //If src is NULL then operation is terminated.
+    if (src == NULL) {
+        return;
+    }
+
+    size_t i;
+    for (i = 0; i < n; i++) {
+        dest[i] = src[i];
+    }
+    dest[i] = '\0';
+}
+
+/**
+Compares two strings for equality - used for unit testing
+@str1 - first string
+@str2 - second string
+return - whether string is equal
+**/
+bool strEqual(char* str1, char* str2) {
+    if (str1 == NULL || str2 == NULL) return (str1 == str2);
+
+    if (myStrLen(str1) != myStrLen(str2)) return false;
+
+    for (int i = 0; str1[i] != '\0'; i++) {
+        if (str1[i] != str2[i]) return false;
+    }
+
+    return true;
+}
+
+/**
+Checks whether a string begins with a given prefix
+@str - string to check
+@prefix - prefix to look for
+@return - whether str begins with prefix
+**/
+bool strPrefix(char* str, char* prefix) {
+    if (str == NULL || prefix == NULL) return false;
+
+    for (int i = 0; prefix[i] != '\0'; i++) {
+        if (str[i] != prefix[i]) return false;
+    }
+
+    return true;
+}
+
+/**
+Converts a 64-bit integer to a string, so that byte counts over 4 GiB are not
+truncated as they would be by myitoa
+@num - positive integer to convert to string
+@str - char* to store converted string, at least MAX_LONG_DIGITS + 1 long
+**/
+void myltoa(unsigned long num, char* str) {
+    char digits[MAX_LONG_DIGITS];
+    int i = 0;
+
+    //Gets digits from least to most significant, then reverses them
+    do {
+        digits[i++] = num % 10;
+        num /= 10;
+    } while (num);
+
+    for (int j = 0; j < i; j++) str[j] = digits[i - 1 - j] + ASCII_CONVERSION_INT;
+    str[i] = '\0';
+}
+
+/**
+Custom implementation of atoi function for non-negative integers
+@str - string to convert
+@return - integer value of str, or -1 if str is not a non-negative integer
+**/
+long myatoi(char* str) {
+    if (str == NULL || str[0] == '\0') return -1;
+
+    long num = 0;
+    for (int i = 0; str[i] != '\0'; i++) {
+        if (str[i] < '0' || str[i] > '9') return -1;
+        num = num * 10 + (str[i] - ASCII_CONVERSION_INT);
+    }
+
+    return num;
+}
+
+/**
+Custom implementation of itoa function
+@num - positive integer to convert to string
+@str - char* to store converted string
+**/
+void myitoa(unsigned int num, char* str) {
+    char intStr[MAX_INT_DIGITS + 1];
+    int i = 0;
+
+    //Assigns 0 string if num is zero
+    if (num == 0) {
+        str[0] = '0';
+        str[1] = '\0';
+        return;
+    }
+
+    //Gets digits from least to most significant (reverse order in array)
+    while (num) {
+        //Gets least significant bit
+        intStr[i++] = num % 10;
+        //Reduces size of num by factor of 10
+        num /= 10;
+    }
+    intStr[i] = '\0';
+
+    //Converts digits to ASCII and reorders in new array
+    for (int j = 0, k = i - 1; j < i; j++, k--) {
+        str[k] = intStr[j] + ASCII_CONVERSION_INT;
+    }
+
+    str[i] = '\0';
+}
+
+/**
+Gets character signifying whether a file is a directory or not
+@meta_data - meta data of file
+@dir - character array to store directory character
+**/
+void getDirChar(struct stat meta_data, char* dir) {
+    dir[0] = S_ISDIR(meta_data.st_mode) ? 'd' : '-';
+    dir[1] = '\0';
+}
+
+/**
+Convenient wrapper for myWrite that prints to stdout
+@str - string to print to stdout
+**/
+void myPrint(char* str) {
+    myWrite(stdout, str, myStrLen(str));
+}
+
+/**
+ Prints cp error message
+ @fileName - file name which causes error
+ @flag - type of error
+**/
+void writeErrorMsg(char* fileName, int flag) {
+    //Separates the errno carried by the flag, if any
+    int err = errorErrno(flag);
+    flag = errorFlag(flag);
+    __atomic_store_n(&failed, true, __ATOMIC_RELAXED);
+
+    if (flag == ERRSTAT)  {
+        myPrint("mycp: cannot stat '");
+        myPrint(fileName);
+        myPrint("' No such file or directory");
+        myPrint("\n");
+    } else if (flag == ERRREC) {
+        myPrint("mycp: -r not specified; omitting directory '");
+        myPrint(fileName);
+        myPrint("'\n");
+    } else if (flag == ERRDEST) {
+        myPrint("mycp: missing destination file operand after '");
+        myPrint(fileName);
+        myPrint("'\n");
+    } else if (flag == ERRDIR) {
+        myPrint("mycp: target '");
+        myPrint(fileName);
+        myPrint("' is not a directory\n");
+    } else if (flag == ERROPT) {
+        myPrint("mycp: invalid option '");
+        myPrint(fileName);
+        myPrint("'\n");
+    } else if (flag == ERRCLONE) {
+        myPrint("mycp: failed to clone '");
+        myPrint(fileName);
+        myPrint("'");
+        printReason(err);
+    } else if (flag == ERRCOPY) {
+        myPrint("mycp: error copying '");
+        myPrint(fileName);
+        myPrint("'");
+        printReason(err);
+    } else if (flag == ERRDEPTH) {
+        myPrint("mycp: invalid queue depth '");
+        myPrint(fileName);
+        myPrint("', must be from 1 to 64\n");
+    } else if (flag == ERRJOBS) {
+        myPrint("mycp: invalid number of threads '");
+        myPrint(fileName);
+        myPrint("', must be from 1 to 64\n");
+    } else if (flag == ERRMKDIR) {
+        myPrint("mycp: cannot create directory '");
+        myPrint(fileName);
+        myPrint("'");
+        printReason(err);
+    } else if (flag == ERRSELF) {
+        myPrint("mycp: cannot copy a directory, '");
+        myPrint(fileName);
+        myPrint("', into itself\n");
+    } else if (flag == ERRPERM) {
+        myPrint("mycp: cannot open '");
+        myPrint(fileName);
+        myPrint("' for reading: Permission denied\n");
+    } else if (flag == ERRVERIFY) {
+        myPrint("mycp: verification of copy of '");
+        myPrint(fileName);
+        myPrint("' failed, checksums do not match\n");
+    } else if (flag == ERRSAME) {
+        myPrint("mycp: '");
+        myPrint(fileName);
+        myPrint("' and its destination are the same file\n");
+    } else if (flag == ERRCREATE) {
+        myPrint("mycp: cannot create copy of '");
+        myPrint(fileName);
+        myPrint("'");
+        printReason(err);
+    } else if (flag == ERROPEN) {
+        myPrint("mycp: cannot open '");
+        myPrint(fileName);
+        myPrint("' for reading");
+        printReason(err);
+    }
+}
+
+/**
+Prints the end of an error message, the description of the errno that caused
+the error if it is known
+@err - errno carried by the error flag, 0 if none
+**/
+void printReason(int err) {
+    char numStr[MAX_INT_DIGITS + 1];
+    char* message = errnoMessage(err);
+
+    if (err == 0) {
+        myPrint("\n");
+    } else if (message != NULL) {
+        myPrint(": ");
+        myPrint(message);
+        myPrint("\n");
+    } else {
+        myitoa(err, numStr);
+        myPrint(": error ");
+        myPrint(numStr);
+        myPrint("\n");
+    }
+}
+
+/**
+Gets the description of an errno, as printed by strerror, for the errors that
+copying files can cause
+@err - positive errno
+@return - description, or NULL if it is not known
+**/
+char* errnoMessage(int err) {
+    switch (err) {
+        case EPERM: return "Operation not permitted";
+        case ENOENT: return "No such file or directory";
+        case EINTR: return "Interrupted system call";
+        case EIO: return "Input/output error";
+        case ENXIO: return "No such device or address";
+        case EBADF: return "Bad file descriptor";
+        case EAGAIN: return "Resource temporarily unavailable";
+        case ENOMEM: return "Cannot allocate memory";
+        case EACCES: return "Permission denied";
+        case EBUSY: return "Device or resource busy";
+        case EEXIST: return "File exists";
+        case EXDEV: return "Invalid cross-device link";
+        case ENODEV: return "No such device";
+        case ENOTDIR: return "Not a directory";
+        case EISDIR: return "Is a directory";
+        case EINVAL: return "Invalid argument";
+        case ENFILE: return "Too many open files in system";
+        case EMFILE: return "Too many open files";
+        case ETXTBSY: return "Text file busy";
+        case EFBIG: return "File too large";
+        case ENOSPC: return "No space left on device";
+        case ESPIPE: return "Illegal seek";
+        case EROFS: return "Read-only file system";
+        case EPIPE: return "Broken pipe";
+        case ENAMETOOLONG: return "File name too long";
+        case ELOOP: return "Too many levels of symbolic links";
+        case EOPNOTSUPP: return "Operation not supported";
+        case EDQUOT: return "Disk quota exceeded";
+        case ESTALE: return "Stale file handle";
+        default: return NULL;
+    }
+}
+
+/**
+Combines an error flag with the errno that caused it, so that both can be
+returned as one int and passed to writeErrorMsg
+@flag - error flag, e.g. ERROPEN
+@err - positive errno
+@return - error to pass to writeErrorMsg
+**/
+int errorWithErrno(int flag, int err) {
+    return -((-flag) | (err << ERRNO_SHIFT));
+}
+
+/**
+Gets the error flag of an error, without any errno it carries
+@error - error returned by errorWithErrno, or a plain flag
+@return - error flag
+**/
+int errorFlag(int error) {
+    return -((-error) & ((1 << ERRNO_SHIFT) - 1));
+}
+
+/**
+Gets the errno carried by an error
+@error - error returned by errorWithErrno, or a plain flag
+@return - errno, or 0 for a plain flag
+**/
+int errorErrno(int error) {
+    return (-error) >> ERRNO_SHIFT;
+}
+
+
+/**
+Runs a given list of unit tests.
+Iterates over each unit test in the list of test functions. If calling the
+current function returns true then the test has passed, otherwise it has failed.
+@testFunctions - list of unit tests to run
+@numTests - num tests to run
+@returns - number of passing unit tests
+*/
+int runTests(bool (*testFunctions[]) (), int numTests) {
+    //Number of tests that have passed
+    int numPassingTests = 0;
+    char printBuf[MAX_INT_DIGITS];
+
+    //Lists result of each unit test
+    int i;
+    for (i = 0; i < numTests; i++) {
+        if ((*testFunctions[i]) ()) {
+            numPassingTests += 1;
+            myPrint(GREEN);
+            myPrint("\n***TEST ");
+            myitoa(i + 1, printBuf);
+            myPrint(printBuf);
+            myPrint(" PASSED***\n");
+        } else {
+            myPrint(RED);
+            myPrint("\n***TEST ");
+            myitoa(i + 1, printBuf);
+            myPrint(printBuf);
+            myPrint(" FAILED***\n");
+        }
+    }
+
+    //Displays total number of unit tests which have passed
+    myPrint("\n***");
+    (numPassingTests > 0) ? myitoa(numPassingTests, printBuf) : myStrCpy(printBuf, "0", 1);
+    myPrint(printBuf);
+    myPrint("/");
+    myitoa(i, printBuf);
+    myPrint(printBuf);
+    myPrint(" TESTS PASSED***\n");
+
+    myPrint(WHITE);
+    return numPassingTests;
+}
+
+/**
+Initialises the array of tests to be run with the address of each unit test function.
+@testFunctions - list of test functions to be called
+**/
+void initTests(bool (*testFunctions[]) ()) {
+    testFunctions[0] = strEqualTest1;
+    testFunctions[1] = strEqualTest2;
+    testFunctions[2] = strEqualTest3;
+    testFunctions[3] = strEqualTest4;
+    testFunctions[4] = myitoaTest1;
+    testFunctions[5] = myitoaTest2;
+    testFunctions[6] = myitoaTest3;
+    testFunctions[7] = myitoaTest4;
+    testFunctions[8] = myStrCpyTest1;
+    testFunctions[9] = myStrCpyTest2;
     testFunctions[10] = myStrCpyTest3;
     testFunctions[11] = myStrCpyTest4;
     testFunctions[12] = myStrLenTest1;
@@ -655,233 +4222,1569 @@ void initTests(bool (*testFunctions[]) ()) {
     testFunctions[30] = myMkdirTest2;
     testFunctions[31] = myRmdirTest1;
     testFunctions[32] = myRmdirTest2;
+    testFunctions[33] = myCopyFileRangeTest1;
+    testFunctions[34] = myCopyFileRangeTest2;
+    testFunctions[35] = writeToFileTest1;
+    testFunctions[36] = mycpTest1;
+    testFunctions[37] = myIoctlTest1;
+    testFunctions[38] = reflinkFileTest1;
+    testFunctions[39] = parseArgsTest1;
+    testFunctions[40] = myLseekTest1;
+    testFunctions[41] = myFtruncateTest1;
+    testFunctions[42] = writeToFileTest2;
+    testFunctions[43] = sparseCopyTest1;
+    testFunctions[44] = myFstatTest1;
+    testFunctions[45] = myMmapTest1;
+    testFunctions[46] = readWriteEngineTest1;
+    testFunctions[47] = writeAllTest1;
+    testFunctions[48] = chooseBufferSizeTest1;
+    testFunctions[49] = chooseBufferSizeTest2;
+    testFunctions[50] = myFallocateTest1;
+    testFunctions[51] = preallocateTest1;
+    testFunctions[52] = strPrefixTest1;
+    testFunctions[53] = myMadviseTest1;
+    testFunctions[54] = mmapEngineTest1;
+    testFunctions[55] = parseArgsTest2;
+    testFunctions[56] = myPipe2Test1;
+    testFunctions[57] = spliceEngineTest1;
+    testFunctions[58] = spliceEngineTest2;
+    testFunctions[59] = mycpTest2;
+    testFunctions[60] = myatoiTest1;
+    testFunctions[61] = uringInitTest1;
+    testFunctions[62] = uringEngineTest1;
+    testFunctions[63] = parseArgsTest3;
+    testFunctions[64] = myStatxTest1;
+    testFunctions[65] = directAlignmentTest1;
+    testFunctions[66] = directEngineTest1;
+    testFunctions[67] = directEngineTest2;
+    testFunctions[68] = copySourceTest1;
+    testFunctions[69] = copyParallelTest1;
+    testFunctions[70] = parseArgsTest4;
+    testFunctions[71] = baseNameTest1;
+    testFunctions[72] = joinPathTest1;
+    testFunctions[73] = popTaskTest1;
+    testFunctions[74] = copyTreeTest1;
+    testFunctions[75] = copyTreeTest2;
+    testFunctions[76] = myOpenatTest1;
+    testFunctions[77] = myMkdiratTest1;
+    testFunctions[78] = myFstatatTest1;
+    testFunctions[79] = myFchmodatTest1;
+    testFunctions[80] = mycpTest3;
+    testFunctions[81] = myltoaTest1;
+    testFunctions[82] = myUtimensatTest1;
+    testFunctions[83] = hashFileTest1;
+    testFunctions[84] = isUnchangedTest1;
+    testFunctions[85] = updateTest1;
+    testFunctions[86] = myPreadTest1;
+    testFunctions[87] = chunksEqualTest1;
+    testFunctions[88] = deltaCopyTest1;
+    testFunctions[89] = deltaCopyTest2;
+    testFunctions[90] = deltaTest1;
+    testFunctions[91] = crc32cTest1;
+    testFunctions[92] = crc32cTest2;
+    testFunctions[93] = crc32cTableTest1;
+    testFunctions[94] = verifyCopyTest1;
+    testFunctions[95] = verifyTest1;
+    testFunctions[96] = errorWithErrnoTest1;
+    testFunctions[97] = copyAtTest1;
+    testFunctions[98] = copyAtTest2;
+    testFunctions[99] = copyAtTest3;
+    testFunctions[100] = copyTreeTest3;
+    testFunctions[101] = spliceEngineTest3;
+    testFunctions[102] = copyDirTest1;
+    testFunctions[103] = mycpTest4;
+}
+
+//Tests that strEqual returns true if two strings are equal
+bool strEqualTest1() {
+    return (strEqual("String", "String"));
+}
+
+//Tests that strEqual returns false if two strings of different lengths are unequal
+bool strEqualTest2() {
+    return (!strEqual("String", "Not String"));
+}
+
+//Tests that strEqual returns false if two strings of the same length are unequal
+bool strEqualTest3() {
+    return (!strEqual("String", "Hello!"));
+}
+
+//Test that strEqual returns true if provided with two NULL strings
+bool strEqualTest4() {
+    return (strEqual(NULL, NULL));
+}
+
+//Tests that myitoa returns string representation of 0
+bool myitoaTest1() {
+    char buf[MAX_INT_DIGITS + 1];
+    myitoa(0, buf);
+    return (strEqual(buf, "0"));
+}
+
+//Tests that myitoa returns string representation of 1
+bool myitoaTest2() {
+    char buf[MAX_INT_DIGITS + 1];
+    myitoa(1, buf);
+    return (strEqual(buf, "1"));
+}
+
+//Tests that myitoa does not return a negative string as an unsigned int is used
+bool myitoaTest3() {
+    char buf[MAX_INT_DIGITS + 1];
+    myitoa(-1, buf);
+    return (!strEqual(buf, "-1"));
+}
+
+//Tests that myitoa converts normal data to string
+bool myitoaTest4() {
+    char buf[MAX_INT_DIGITS + 1];
+    myitoa(1024, buf);
+    return (strEqual(buf, "1024"));
+}
+
+//Tests that myStrCpy can copy a normal string from one buffer to another
+bool myStrCpyTest1() {
+    char buf[BUF_SIZE];
+    char str[BUF_SIZE] = "Hello";
+    myStrCpy(buf, str, myStrLen(str));
+    return (strEqual(buf, "Hello"));
+}
+
+//Tests that myStrCpy can copy an empty string
+bool myStrCpyTest2() {
+    char buf[BUF_SIZE];
+    char str[BUF_SIZE] = "";
+    myStrCpy(buf, str, myStrLen(str));
+    return (strEqual(buf, ""));
+}
+
+//Tests that myStrCpy can copy a pathname
+bool myStrCpyTest3() {
+    char buf[BUF_SIZE];
+    char str[BUF_SIZE] = "~/Documents/CS3104/practicals/CS3104-P1-Sysutil";
+    myStrCpy(buf, str, myStrLen(str));
+    return (strEqual(buf, "~/Documents/CS3104/practicals/CS3104-P1-Sysutil"));
+}
+
+//Tests to make sure that myStrCpy refuses to copy a NULL pointer
+bool myStrCpyTest4() {
+    char buf[BUF_SIZE] = "Original String";
+    char* str = NULL;
+    myStrCpy(buf, str, myStrLen(str));
+    return (strEqual(buf, "Original String"));
+}
+
+//Test myStrCpy with some normal test data
+bool myStrLenTest1() {
+    char buf[6] = "Hello";
+    return (myStrLen(buf) == 5);
+}
+
+//Tests myStrLen with an empty string
+bool myStrLenTest2() {
+    char buf[10] = "";
+    return (myStrLen(buf) == 0);
+}
+
+//Tests myStrLen with NULL
+bool myStrLenTest3() {
+    char* buf = NULL;
+    return (myStrLen(buf) == -1);
+}
+
+//Tests that myStat returns 0 for a valid file
+bool myStatTest1() {
+    struct stat meta_data;
+    int status = myStat("mycp.c", &meta_data);
+    return (status == 0);
+}
+
+//Tests that myStat returns an error number for a NULL file pointer
+bool myStatTest2() {
+    struct stat meta_data;
+    int status = myStat(NULL, &meta_data);
+    return (status != 0);
+}
+
+//Tests that myStat returns an error number for a non-existent file
+bool myStatTest3() {
+    struct stat meta_data;
+    int status = myStat("Non-existent file", &meta_data);
+    return (status != 0);
+}
+
+//Tests that valid file opens successfully for read only
+bool myOpenTest1() {
+    int fd = myOpen("mycp.c", O_RDONLY);
+    myClose(fd);
+    return (fd != -1);
+}
+
+//Tests that invalid file failes to open successfully and return positive fd
+bool myOpenTest2() {
+    int fd = myOpen("Non-existent file", O_RDONLY);
+    myClose(fd);
+    return (fd < 0);
+}
+
+//Tests that valid open file is closed successfully
+bool myCloseTest1() {
+    int fd = myOpen("mycp.c", O_RDONLY);
+    int status =  myClose(fd);
+    return (status == 0);
 }
 
-//Tests that strEqual returns true if two strings are equal
-bool strEqualTest1() {
-    return (strEqual("String", "String"));
+//Tests that unopened file cannot be closes successfully
+bool myCloseTest2() {
+    int fd = myOpen("Non-existent file", O_RDONLY);
+    int status = myClose(fd);
+    return (status != 0);
+}
+
+//Tests that zero bytes are written for empty string
+bool myWriteTest1() {
+    char buf[BUF_SIZE] = "";
+    int bytesWritten = myWrite(stdout, buf, myStrLen(buf));
+    return (bytesWritten == 0);
+}
+
+//Tests that valid positive number of bytes are written for string
+bool myWriteTest2() {
+    char buf[BUF_SIZE] = "\n~/Documents/CS3104/practicals/CS3104-P1-Sysutil\n";
+    int bytesWritten = myWrite(stdout, buf, myStrLen(buf));
+    return (bytesWritten == myStrLen(buf));
+}
+
+//Tests that error code is returned when trying to write NULL string
+bool myWriteTest3() {
+    char* buf = NULL;
+    int bytesWritten = myWrite(stdout, buf, myStrLen(buf));
+    return (bytesWritten < 0);
+}
+
+//Tests that new file can be created successfully
+bool myCreatTest1() {
+    int fd = myCreat("NewFile.txt", O_RDONLY);
+    myUnlink("NewFile.txt");
+    return (fd > 0);
+}
+
+//Tests that error is returned when file name is NULL
+bool myCreatTest2() {
+    int fd = myCreat(NULL, O_RDONLY);
+    return (fd < 0);
+}
+
+//Tests that file is successfully deleted
+bool myUnlinkTest1() {
+    myCreat("NewFile.txt", O_RDONLY);
+    int status = myUnlink("NewFile.txt");
+    return (status == 0);
+}
+
+//Tests that error is returned when attempt is made to delete non-existent file
+bool myUnlinkTest2() {
+    int status = myUnlink("Non-existent.txt");
+    return (status < 0);
+}
+
+//Tests that directory can be created successfully
+bool myMkdirTest1() {
+    int status = mymkdir("Test Directory", O_RDONLY);
+    myrmdir("Test Directory");
+    return (status == 0);
+}
+
+//Tests that error is returned for invalid directory creation
+bool myMkdirTest2() {
+    int status = mymkdir(NULL, O_RDONLY);
+    return (status < 0);
+}
+
+//Tests that empty directory can be successfully deleted
+bool myRmdirTest1() {
+    mymkdir("Test Directory", O_RDONLY);
+    int status = myrmdir("Test Directory");
+    return (status == 0);
+}
+
+//Tests that non-empty directory cannot be deleted
+bool myRmdirTest2() {
+    //Gives permissiosn in order to be able to delete file
+    mymkdir("TestDirectory", 0775);
+    int fd = myCreat("TestDirectory/NewFile.txt", O_RDONLY);
+    myClose(fd);
+    int status = myrmdir("TestDirectory");
+
+    //Clean up
+    myUnlink("TestDirectory/NewFile.txt");
+    myrmdir("TestDirectory");
+
+    return (status < 0);
+}
+
+/**
+Creates a file containing a string, replacing any existing file
+@fileName - name of file to create
+@contents - string to write to file
+@return - whether the file was created and written successfully
+**/
+bool createTestFile(char* fileName, char* contents) {
+    int fd = myCreat(fileName, 0644);
+    if (fd < 0) return false;
+    int bytesWritten = myWrite(fd, contents, myStrLen(contents));
+    myClose(fd);
+    return (bytesWritten == myStrLen(contents));
+}
+
+/**
+Checks whether a file contains exactly a given string
+@fileName - name of file to check
+@contents - expected contents of file
+@return - whether the file's contents equal contents
+**/
+bool fileContains(char* fileName, char* contents) {
+    char buf[BUF_SIZE];
+    int fd = myOpen(fileName, O_RDONLY);
+    if (fd < 0) return false;
+    int bytesRead = myRead(fd, buf, BUF_SIZE - 1);
+    myClose(fd);
+    if (bytesRead < 0) return false;
+    buf[bytesRead] = '\0';
+    return strEqual(buf, contents);
+}
+
+//Tests that copy_file_range copies the contents of one file to another
+bool myCopyFileRangeTest1() {
+    createTestFile("Source.txt", "Copied by the kernel");
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    long copied = myCopyFileRange(src, NULL, dest, NULL, CFR_CHUNK_SIZE, 0);
+    myClose(src);
+    myClose(dest);
+
+    bool equal = fileContains("Dest.txt", "Copied by the kernel");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (copied == myStrLen("Copied by the kernel") && equal);
+}
+
+//Tests that copy_file_range returns an error for an invalid file descriptor
+bool myCopyFileRangeTest2() {
+    int dest = myCreat("Dest.txt", 0644);
+    long copied = myCopyFileRange(-1, NULL, dest, NULL, CFR_CHUNK_SIZE, 0);
+    myClose(dest);
+    myUnlink("Dest.txt");
+    return (copied < 0);
+}
+
+//Tests that writeToFile copies a whole file
+bool writeToFileTest1() {
+    createTestFile("Source.txt", "Hello\nWorld\n");
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    struct copyFile file;
+    struct stat src_meta_data;
+    myFstat(src, &src_meta_data);
+    initCopyFile(&file, dest, src, &src_meta_data);
+    writeToFile(&file, -1);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+
+    bool equal = fileContains("Dest.txt", "Hello\nWorld\n");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return equal;
+}
+
+//Tests that mycp creates a destination file that does not exist
+bool mycpTest1() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "New destination");
+    myUnlink("Dest.txt");
+    myStat("Source.txt", &src_meta_data);
+    mycp("Dest.txt", "Source.txt", &src_meta_data);
+
+    bool equal = fileContains("Dest.txt", "New destination");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return equal;
+}
+
+//Tests that ioctl returns an error for an invalid file descriptor
+bool myIoctlTest1() {
+    return (myIoctl(-1, FICLONE, 0) < 0);
+}
+
+/*Tests that reflinkFile either clones a file or reports that cloning is not
+supported, and that --reflink=auto still copies the file in that case*/
+bool reflinkFileTest1() {
+    createTestFile("Source.txt", "Cloned or copied");
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    int status = reflinkFile(dest, src);
+    myClose(src);
+    myClose(dest);
+    bool valid = (status == 0) ? fileContains("Dest.txt", "Cloned or copied")
+                               : (status == -EOPNOTSUPP || status == -EXDEV || status == -EINVAL);
+
+    struct stat src_meta_data;
+    myStat("Source.txt", &src_meta_data);
+    options.reflink = REFLINK_AUTO;
+    mycp("Dest.txt", "Source.txt", &src_meta_data);
+    bool copied = fileContains("Dest.txt", "Cloned or copied");
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (valid && copied);
+}
+
+//Tests that reflink options are parsed and file arguments are found after them
+bool parseArgsTest1() {
+    char* argv[4] = { "mycp", "--reflink=never", "Source.txt", "Dest.txt" };
+    int argIndex = parseArgs(4, argv);
+    bool parsed = (argIndex == 2 && options.reflink == REFLINK_NEVER);
+    options.reflink = REFLINK_AUTO;
+    return parsed;
+}
+
+//Tests that lseek moves to the end of a file and returns its size
+bool myLseekTest1() {
+    createTestFile("Source.txt", "Twelve bytes");
+    int fd = myOpen("Source.txt", O_RDONLY);
+    off_t offset = myLseek(fd, 0, SEEK_END);
+    myClose(fd);
+    myUnlink("Source.txt");
+    return (offset == 12);
+}
+
+//Tests that ftruncate extends a file
+bool myFtruncateTest1() {
+    struct stat meta_data;
+    int fd = myCreat("Dest.txt", 0644);
+    int status = myFtruncate(fd, 1024);
+    myClose(fd);
+    myStat("Dest.txt", &meta_data);
+    myUnlink("Dest.txt");
+    return (status == 0 && meta_data.st_size == 1024);
+}
+
+//Tests that writeToFile stops after the given number of bytes
+bool writeToFileTest2() {
+    createTestFile("Source.txt", "Hello World");
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    struct copyFile file;
+    struct stat src_meta_data;
+    myFstat(src, &src_meta_data);
+    initCopyFile(&file, dest, src, &src_meta_data);
+    long copied = writeToFile(&file, 5);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+
+    bool equal = fileContains("Dest.txt", "Hello");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (copied == 5 && equal);
+}
+
+/*Tests that sparseCopy keeps the size and data of a sparse file while
+allocating no more blocks than the source*/
+bool sparseCopyTest1() {
+    struct stat src_meta_data;
+    struct stat dest_meta_data;
+    char buf[2];
+
+    //Creates a 16 MiB file with data at the start and at 8 MiB
+    int fd = myCreat("Source.txt", 0644);
+    myWrite(fd, "A", 1);
+    myLseek(fd, 8 * 1024 * 1024, SEEK_SET);
+    myWrite(fd, "B", 1);
+    myFtruncate(fd, 16 * 1024 * 1024);
+    myClose(fd);
+
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    struct copyFile file;
+    myFstat(src, &src_meta_data);
+    initCopyFile(&file, dest, src, &src_meta_data);
+    long copied = sparseCopy(&file, 16 * 1024 * 1024);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+
+    myStat("Source.txt", &src_meta_data);
+    myStat("Dest.txt", &dest_meta_data);
+
+    //Reads back the byte at 8 MiB
+    fd = myOpen("Dest.txt", O_RDONLY);
+    myLseek(fd, 8 * 1024 * 1024, SEEK_SET);
+    myRead(fd, buf, 1);
+    myClose(fd);
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (copied > 0 && dest_meta_data.st_size == src_meta_data.st_size
+            && dest_meta_data.st_blocks <= src_meta_data.st_blocks && buf[0] == 'B');
+}
+
+//Tests that fstat gets the meta data of an open file
+bool myFstatTest1() {
+    struct stat meta_data;
+    int fd = myOpen("mycp.c", O_RDONLY);
+    int status = myFstat(fd, &meta_data);
+    myClose(fd);
+    return (status == 0 && S_ISREG(meta_data.st_mode));
+}
+
+//Tests that an anonymous mapping can be created, written to and removed
+bool myMmapTest1() {
+    char* buf = myMmap(NULL, MIN_COPY_BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) return false;
+    buf[MIN_COPY_BUF_SIZE - 1] = 'a';
+    bool written = (buf[MIN_COPY_BUF_SIZE - 1] == 'a');
+    return (written && myMunmap(buf, MIN_COPY_BUF_SIZE) == 0);
+}
+
+//Tests that the read/write engine copies a file larger than its buffer
+bool readWriteEngineTest1() {
+    struct stat src_meta_data;
+    struct stat dest_meta_data;
+
+    //Creates a file of 3 buffers and a bit, filled with a repeating pattern
+    int fd = myCreat("Source.txt", 0644);
+    char block[PAGE_SIZE];
+    for (int i = 0; i < PAGE_SIZE; i++) block[i] = 'a' + i % 26;
+    for (int i = 0; i < 3 * MIN_COPY_BUF_SIZE / PAGE_SIZE + 1; i++) myWrite(fd, block, PAGE_SIZE);
+    myClose(fd);
+
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    struct copyFile file;
+    myFstat(src, &src_meta_data);
+    initCopyFile(&file, dest, src, &src_meta_data);
+    file.bufSize = MIN_COPY_BUF_SIZE;
+    long copied = readWriteEngine(&file, -1);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+
+    myStat("Dest.txt", &dest_meta_data);
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (copied == src_meta_data.st_size && dest_meta_data.st_size == src_meta_data.st_size);
+}
+
+//Tests that writeAll returns an error for an invalid file descriptor
+bool writeAllTest1() {
+    return (writeAll(-1, "Hello", 5) < 0);
+}
+
+//Tests that small files use the smallest buffer and large files the largest
+bool chooseBufferSizeTest1() {
+    struct stat src_meta_data;
+    struct stat dest_meta_data;
+    src_meta_data.st_mode = S_IFREG;
+    src_meta_data.st_blksize = PAGE_SIZE;
+    dest_meta_data.st_blksize = PAGE_SIZE;
+
+    src_meta_data.st_size = 10;
+    size_t small = chooseBufferSize(&src_meta_data, &dest_meta_data);
+    src_meta_data.st_size = 10L * 1024 * 1024 * 1024;
+    size_t large = chooseBufferSize(&src_meta_data, &dest_meta_data);
+    return (small == MIN_COPY_BUF_SIZE && large == MAX_COPY_BUF_SIZE);
+}
+
+//Tests that the buffer size is a multiple of a large block size
+bool chooseBufferSizeTest2() {
+    struct stat src_meta_data;
+    struct stat dest_meta_data;
+    src_meta_data.st_mode = S_IFREG;
+    src_meta_data.st_size = 1000000;
+    src_meta_data.st_blksize = PAGE_SIZE;
+    dest_meta_data.st_blksize = 3 * 65536;
+
+    size_t size = chooseBufferSize(&src_meta_data, &dest_meta_data);
+    return (size % dest_meta_data.st_blksize == 0 && size >= 1000000);
+}
+
+//Tests that fallocate returns an error for an invalid file descriptor
+bool myFallocateTest1() {
+    return (myFallocate(-1, 0, 0, PAGE_SIZE) < 0);
+}
+
+/*Tests that preallocate reserves blocks without changing the size of the file,
+or reports that the filesystem does not support it*/
+bool preallocateTest1() {
+    struct stat meta_data;
+    int fd = myCreat("Dest.txt", 0644);
+    int status = preallocate(fd, MIN_COPY_BUF_SIZE);
+    myFstat(fd, &meta_data);
+    myClose(fd);
+    myUnlink("Dest.txt");
+
+    if (status == -EOPNOTSUPP) return true;
+    return (status == 0 && meta_data.st_size == 0 && meta_data.st_blocks * 512 >= MIN_COPY_BUF_SIZE);
+}
+
+//Tests that strPrefix finds a prefix of an option and rejects a longer prefix
+bool strPrefixTest1() {
+    return (strPrefix("--engine=mmap", "--engine=") && !strPrefix("--eng", "--engine="));
+}
+
+//Tests that madvise returns an error for an unaligned address
+bool myMadviseTest1() {
+    return (myMadvise((void*) 1, PAGE_SIZE, MADV_SEQUENTIAL) < 0);
+}
+
+/**
+Creates Source.txt of a given size filled with a pattern, copies it to Dest.txt
+with an engine starting from an offset, and checks the copy
+@engine - engine to copy with
+@fileSize - size of source file
+@start - offset of source to copy from, unaligned offsets check that engines
+handle an unaligned start
+@len - number of bytes to copy, or negative to copy until the end
+@return - whether the copied bytes match the source
+**/
+bool engineCopies(int engine, long fileSize, off_t start, long len) {
+    char block[PAGE_SIZE];
+    char copy[PAGE_SIZE];
+    int fd = myCreat("Source.txt", 0644);
+    for (long written = 0; written < fileSize; written += PAGE_SIZE) {
+        for (int i = 0; i < PAGE_SIZE; i++) block[i] = 'a' + (written / PAGE_SIZE + i) % 26;
+        myWrite(fd, block, (fileSize - written < PAGE_SIZE) ? fileSize - written : PAGE_SIZE);
+    }
+    myClose(fd);
+
+    struct stat src_meta_data;
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+    struct copyFile file;
+    myFstat(src, &src_meta_data);
+    initCopyFile(&file, dest, src, &src_meta_data);
+    myLseek(src, start, SEEK_SET);
+
+    int oldEngine = options.engine;
+    options.engine = engine;
+    long copied = writeToFile(&file, len);
+    options.engine = oldEngine;
+    off_t srcOffset = myLseek(src, 0, SEEK_CUR);
+    freeCopyFile(&file);
+    myClose(dest);
+
+    //Compares the copy with the source a page at a time
+    long expected = (len >= 0) ? len : fileSize - start;
+    bool equal = (copied == expected && srcOffset == start + expected);
+    dest = myOpen("Dest.txt", O_RDONLY);
+    myLseek(src, start, SEEK_SET);
+    long bytesRead;
+    while (equal && (bytesRead = myRead(src, block, PAGE_SIZE)) > 0) {
+        if (myRead(dest, copy, bytesRead) != bytesRead) {
+            equal = (expected < fileSize - start);
+            break;
+        }
+        for (int i = 0; i < bytesRead; i++) equal = equal && (block[i] == copy[i]);
+    }
+    myClose(src);
+    myClose(dest);
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return equal;
+}
+
+//Tests that the mmap engine copies a file larger than its window from an unaligned offset
+bool mmapEngineTest1() {
+    return engineCopies(ENGINE_MMAP, MMAP_WINDOW_SIZE + 3 * PAGE_SIZE + 17, 100, -1);
+}
+
+//Tests that --engine selects an engine and an unknown engine is rejected
+bool parseArgsTest2() {
+    char* argv[3] = { "mycp", "--engine=mmap", "Source.txt" };
+    int argIndex = parseArgs(3, argv);
+    bool parsed = (argIndex == 2 && options.engine == ENGINE_MMAP);
+
+    char* badArgv[3] = { "mycp", "--engine=fast", "Source.txt" };
+    options.engine = ENGINE_AUTO;
+    bool rejected = (parseArgs(3, badArgv) < 0);
+    options.engine = ENGINE_AUTO;
+    return (parsed && rejected);
+}
+
+//Tests that pipe2 creates a pipe that data written to can be read back from
+bool myPipe2Test1() {
+    int pipeFds[2];
+    char buf[BUF_SIZE];
+    if (myPipe2(pipeFds, O_CLOEXEC) != 0) return false;
+
+    myWrite(pipeFds[1], "Hello", 5);
+    int bytesRead = myRead(pipeFds[0], buf, BUF_SIZE);
+    myClose(pipeFds[0]);
+    myClose(pipeFds[1]);
+    return (bytesRead == 5 && buf[0] == 'H' && buf[4] == 'o');
+}
+
+//Tests that the splice engine copies a regular file with sendfile from an unaligned offset
+bool spliceEngineTest1() {
+    return engineCopies(ENGINE_SPLICE, 3 * PAGE_SIZE + 17, 100, -1) && engineCopies(ENGINE_SPLICE, 5 * PAGE_SIZE, 100, 2 * PAGE_SIZE);
+}
+
+//Tests that the auto engine splices the contents of a pipe into a file
+bool spliceEngineTest2() {
+    int pipeFds[2];
+    struct stat src_meta_data;
+    struct copyFile file;
+    if (myPipe2(pipeFds, O_CLOEXEC) != 0) return false;
+    myWrite(pipeFds[1], "Hello World!", 12);
+    myClose(pipeFds[1]);
+
+    int dest = myCreat("Dest.txt", 0644);
+    myFstat(pipeFds[0], &src_meta_data);
+    initCopyFile(&file, dest, pipeFds[0], &src_meta_data);
+    long copied = writeToFile(&file, -1);
+    bool stream = file.stream;
+    freeCopyFile(&file);
+    myClose(dest);
+    myClose(pipeFds[0]);
+
+    bool equal = fileContains("Dest.txt", "Hello World!");
+    myUnlink("Dest.txt");
+    return (stream && copied == 12 && equal);
+}
+
+//Tests that mycp copies a file in /proc, which reports a size of 0
+bool mycpTest2() {
+    struct stat src_meta_data;
+    struct stat dest_meta_data;
+    myStat("/proc/self/stat", &src_meta_data);
+    mycp("Dest.txt", "/proc/self/stat", &src_meta_data);
+
+    int status = myStat("Dest.txt", &dest_meta_data);
+    myUnlink("Dest.txt");
+    return (src_meta_data.st_size == 0 && status == 0 && dest_meta_data.st_size > 0);
+}
+
+//Tests that myatoi converts a number and rejects a string with other characters
+bool myatoiTest1() {
+    return (myatoi("64") == 64 && myatoi("8k") == -1 && myatoi("") == -1);
+}
+
+//Tests that an io_uring can be set up and torn down. Passes if io_uring is unavailable
+bool uringInitTest1() {
+    struct uringQueue ring;
+    int status = uringInit(&ring, DEFAULT_QUEUE_DEPTH);
+    if (status != 0) return (status == -EOPNOTSUPP || status == -ENOSYS || status == -EPERM);
+
+    bool valid = (ring.fd >= 0 && ring.sqEntries >= DEFAULT_QUEUE_DEPTH);
+    uringExit(&ring);
+    return valid;
+}
+
+/*Tests that the io_uring engine copies a file of more chunks than buffers from an
+unaligned offset, and part of a file. The engine falls back to read/write if
+io_uring is unavailable*/
+bool uringEngineTest1() {
+    int oldDepth = options.queueDepth;
+    options.queueDepth = 2;
+    bool copied = engineCopies(ENGINE_URING, 5 * URING_BUF_SIZE + 17, 100, -1)
+        && engineCopies(ENGINE_URING, 3 * URING_BUF_SIZE, 100, URING_BUF_SIZE + PAGE_SIZE);
+    options.queueDepth = oldDepth;
+    return copied;
+}
+
+//Tests that --queue-depth is parsed and an out of range depth is rejected
+bool parseArgsTest3() {
+    char* argv[3] = { "mycp", "--queue-depth=32", "Source.txt" };
+    bool parsed = (parseArgs(3, argv) == 2 && options.queueDepth == 32);
+
+    char* badArgv[3] = { "mycp", "--queue-depth=0", "Source.txt" };
+    bool rejected = (parseArgs(3, badArgv) < 0);
+    options.queueDepth = DEFAULT_QUEUE_DEPTH;
+    return (parsed && rejected);
+}
+
+//Tests that statx of an open file gets its size
+bool myStatxTest1() {
+    struct statx stx;
+    createTestFile("Test.txt", "Hello");
+    int fd = myOpen("Test.txt", O_RDONLY);
+    int status = myStatx(fd, "", AT_EMPTY_PATH, STATX_SIZE, &stx);
+    myClose(fd);
+    myUnlink("Test.txt");
+    return (status == 0 && stx.stx_size == 5);
+}
+
+//Tests that the O_DIRECT alignment of a file is a power of two, or 0 if unsupported
+bool directAlignmentTest1() {
+    createTestFile("Test.txt", "Hello");
+    int fd = myOpen("Test.txt", O_RDONLY);
+    size_t align = directAlignment(fd);
+    myClose(fd);
+    myUnlink("Test.txt");
+    return ((align & (align - 1)) == 0);
+}
+
+/*Tests that --direct copies a file with an unaligned tail from the start, and
+that O_DIRECT is turned off again afterwards*/
+bool directEngineTest1() {
+    options.direct = true;
+    bool copied = engineCopies(ENGINE_AUTO, 3 * MIN_COPY_BUF_SIZE + 17, 0, -1);
+    options.direct = false;
+
+    int fd = myCreat("Test.txt", 0644);
+    setDirect(fd, true);
+    setDirect(fd, false);
+    bool cleared = !(myFcntl(fd, F_GETFL, 0) & O_DIRECT);
+    myClose(fd);
+    myUnlink("Test.txt");
+    return (copied && cleared);
+}
+
+//Tests that --direct copies from an unaligned offset, using the buffered fallback
+bool directEngineTest2() {
+    options.direct = true;
+    bool copied = engineCopies(ENGINE_AUTO, 3 * PAGE_SIZE + 17, 100, -1)
+        && engineCopies(ENGINE_AUTO, DROP_CACHE_CHUNK + 2 * PAGE_SIZE, 100, DROP_CACHE_CHUNK + 1);
+    options.direct = false;
+    return copied;
+}
+
+//Tests that copySource returns the errors of a missing source and a directory source
+bool copySourceTest1() {
+    mymkdir("TestDir", 0755);
+    int missing = copySource("Dest.txt", "Missing.txt");
+    int directory = copySource("Dest.txt", "TestDir");
+    myrmdir("TestDir");
+    return (missing == ERRSTAT && directory == ERRREC);
+}
+
+/*Tests that a pool of workers copies every source into a directory and stores
+the error of a missing source at its index*/
+bool copyParallelTest1() {
+    char names[16][16];
+    char* sources[16];
+    int results[16];
+    bool copied = true;
+
+    mymkdir("TestDir", 0755);
+    for (int i = 0; i < 16; i++) {
+        myStrCpy(names[i], "Test", 4);
+        myitoa(i, names[i] + 4);
+        sources[i] = names[i];
+        if (i != 5) createTestFile(names[i], names[i]);
+    }
+
+    int status = copyParallel(sources, 16, "TestDir", 4, results);
+
+    //Checks the contents of each copy and removes the sources and copies
+    for (int i = 0; i < 16; i++) {
+        char path[32];
+        myStrCpy(path, "TestDir/", 8);
+        myStrCpy(path + 8, names[i], myStrLen(names[i]));
+        if (i == 5) {
+            copied = copied && (results[i] == ERRSTAT);
+        } else {
+            copied = copied && (results[i] == 0) && fileContains(path, names[i]);
+            myUnlink(path);
+            myUnlink(names[i]);
+        }
+    }
+    myrmdir("TestDir");
+
+    return (status == 0 && copied);
+}
+
+//Tests that -j sets the number of threads and an out of range number is rejected
+bool parseArgsTest4() {
+    char* argv[4] = { "mycp", "-j", "8", "Source.txt" };
+    bool parsed = (parseArgs(4, argv) == 3 && options.numThreads == 8);
+
+    char* badArgv[4] = { "mycp", "-j", "65", "Source.txt" };
+    bool rejected = (parseArgs(4, badArgv) < 0);
+    options.numThreads = 1;
+    return (parsed && rejected);
 }
 
-//Tests that strEqual returns false if two strings of different lengths are unequal
-bool strEqualTest2() {
-    return (!strEqual("String", "Not String"));
+//Tests that baseName gets the last component of paths with and without trailing '/'s
+bool baseNameTest1() {
+    bool plain = strEqual(baseName("../dir/TestDir"), "TestDir");
+    bool trailing = strEqual(baseName("TestDir//"), "TestDir");
+    return (plain && trailing && strEqual(baseName("/"), "/"));
 }
 
-//Tests that strEqual returns false if two strings of the same length are unequal
-bool strEqualTest3() {
-    return (!strEqual("String", "Hello!"));
+//Tests that joinPath joins a directory and name, and rejects a path that is too long
+bool joinPathTest1() {
+    char buf[BUF_SIZE];
+    char longName[BUF_SIZE];
+    for (int i = 0; i < BUF_SIZE - 1; i++) longName[i] = 'a';
+    longName[BUF_SIZE - 1] = '\0';
+
+    bool joined = joinPath(buf, "TestDir", "Test.txt") && strEqual(buf, "TestDir/Test.txt");
+    return (joined && !joinPath(buf, "TestDir", longName));
 }
 
-//Test that strEqual returns true if provided with two NULL strings
-bool strEqualTest4() {
-    return (strEqual(NULL, NULL));
+/*Tests that the owner of a deque takes the newest directory and a thief takes
+the oldest, after the deque has grown past its initial size*/
+bool popTaskTest1() {
+    struct treeCopy tree;
+    struct treeWorker* worker = &tree.workers[0];
+    struct treeTask task;
+    char name[MAX_INT_DIGITS + 1];
+
+    tree.pending = 0;
+    tree.idle = 0;
+    pthread_mutex_init(&tree.lock, NULL);
+    worker->tree = &tree;
+    worker->deque.tasks = NULL;
+    worker->deque.capacity = 0;
+    worker->deque.top = 0;
+    worker->deque.bottom = 0;
+    pthread_mutex_init(&worker->deque.lock, NULL);
+    worker->arena.block = NULL;
+
+    bool pushed = true;
+    for (int i = 0; i < INITIAL_DEQUE_SIZE + 1; i++) {
+        myitoa(i, name);
+        pushed = pushed && pushDir(worker, name, "dest");
+    }
+
+    bool newest = popTask(&worker->deque, &task, false) && strEqual(task.src, "64") && strEqual(task.dest, "dest");
+    bool oldest = popTask(&worker->deque, &task, true) && strEqual(task.src, "0") && task.type == TASK_DIR;
+
+    myMunmap(worker->deque.tasks, worker->deque.capacity * sizeof(struct treeTask));
+    pthread_mutex_destroy(&worker->deque.lock);
+    pthread_mutex_destroy(&tree.lock);
+    arenaFree(&worker->arena);
+    return (pushed && newest && oldest && tree.pending == INITIAL_DEQUE_SIZE + 1);
 }
 
-//Tests that myitoa returns string representation of 0
-bool myitoaTest1() {
-    char buf[MAX_INT_DIGITS + 1];
-    myitoa(0, buf);
-    return (strEqual(buf, "0"));
+/*Tests that -r copies a tree with nested directories using several workers,
+creating the destination when it does not exist*/
+bool copyTreeTest1() {
+    struct stat meta_data;
+    mymkdir("TestDir", 0755);
+    mymkdir("TestDir/Sub", 0755);
+    mymkdir("TestDir/Sub/Sub2", 0755);
+    mymkdir("TestDir/Empty", 0755);
+    createTestFile("TestDir/a.txt", "a");
+    createTestFile("TestDir/Sub/b.txt", "b");
+    createTestFile("TestDir/Sub/Sub2/c.txt", "c");
+
+    options.recursive = true;
+    options.numThreads = 4;
+    int status = copySource("TestCopy", "TestDir");
+    options.recursive = false;
+    options.numThreads = 1;
+
+    bool copied = fileContains("TestCopy/a.txt", "a") && fileContains("TestCopy/Sub/b.txt", "b")
+        && fileContains("TestCopy/Sub/Sub2/c.txt", "c")
+        && myStat("TestCopy/Empty", &meta_data) == 0 && S_ISDIR(meta_data.st_mode);
+
+    char* files[6] = { "TestDir/a.txt", "TestDir/Sub/b.txt", "TestDir/Sub/Sub2/c.txt",
+        "TestCopy/a.txt", "TestCopy/Sub/b.txt", "TestCopy/Sub/Sub2/c.txt" };
+    char* dirs[8] = { "TestDir/Sub/Sub2", "TestDir/Sub", "TestDir/Empty", "TestDir",
+        "TestCopy/Sub/Sub2", "TestCopy/Sub", "TestCopy/Empty", "TestCopy" };
+    for (int i = 0; i < 6; i++) myUnlink(files[i]);
+    for (int i = 0; i < 8; i++) myrmdir(dirs[i]);
+
+    return (status == 0 && copied);
 }
 
-//Tests that myitoa returns string representation of 1
-bool myitoaTest2() {
-    char buf[MAX_INT_DIGITS + 1];
-    myitoa(1, buf);
-    return (strEqual(buf, "1"));
+//Tests that -r copies a directory into an existing directory under its own name
+bool copyTreeTest2() {
+    mymkdir("TestDir", 0755);
+    mymkdir("TestCopy", 0755);
+    createTestFile("TestDir/a.txt", "a");
+
+    options.recursive = true;
+    int status = copySource("TestCopy", "TestDir/");
+    options.recursive = false;
+
+    bool copied = fileContains("TestCopy/TestDir/a.txt", "a");
+    myUnlink("TestDir/a.txt");
+    myUnlink("TestCopy/TestDir/a.txt");
+    myrmdir("TestDir");
+    myrmdir("TestCopy/TestDir");
+    myrmdir("TestCopy");
+
+    return (status == 0 && copied);
 }
 
-//Tests that myitoa does not return a negative string as an unsigned int is used
-bool myitoaTest3() {
-    char buf[MAX_INT_DIGITS + 1];
-    myitoa(-1, buf);
-    return (!strEqual(buf, "-1"));
+//Tests that openat creates a file relative to an open directory
+bool myOpenatTest1() {
+    struct stat meta_data;
+    mymkdir("TestDir", 0755);
+    int dirfd = myOpenat(AT_FDCWD, "TestDir", O_RDONLY | O_DIRECTORY, 0);
+    int fd = myOpenat(dirfd, "Test.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    myClose(fd);
+    myClose(dirfd);
+
+    int status = myStat("TestDir/Test.txt", &meta_data);
+    myUnlink("TestDir/Test.txt");
+    myrmdir("TestDir");
+    return (dirfd >= 0 && fd >= 0 && status == 0);
 }
 
-//Tests that myitoa converts normal data to string
-bool myitoaTest4() {
-    char buf[MAX_INT_DIGITS + 1];
-    myitoa(1024, buf);
-    return (strEqual(buf, "1024"));
+//Tests that mkdirat creates a directory relative to an open directory, and fails if it exists
+bool myMkdiratTest1() {
+    struct stat meta_data;
+    mymkdir("TestDir", 0755);
+    int dirfd = myOpenat(AT_FDCWD, "TestDir", O_RDONLY | O_DIRECTORY, 0);
+    int created = myMkdirat(dirfd, "Sub", 0755);
+    int exists = myMkdirat(dirfd, "Sub", 0755);
+    myClose(dirfd);
+
+    bool isDir = (myStat("TestDir/Sub", &meta_data) == 0 && S_ISDIR(meta_data.st_mode));
+    myrmdir("TestDir/Sub");
+    myrmdir("TestDir");
+    return (created == 0 && exists == -EEXIST && isDir);
 }
 
-//Tests that myStrCpy can copy a normal string from one buffer to another
-bool myStrCpyTest1() {
-    char buf[BUF_SIZE];
-    char str[BUF_SIZE] = "Hello";
-    myStrCpy(buf, str, myStrLen(str));
-    return (strEqual(buf, "Hello"));
+//Tests that fstatat gets the meta data of a file relative to an open directory
+bool myFstatatTest1() {
+    struct stat meta_data;
+    mymkdir("TestDir", 0755);
+    createTestFile("TestDir/Test.txt", "Hello");
+    int dirfd = myOpenat(AT_FDCWD, "TestDir", O_RDONLY | O_DIRECTORY, 0);
+    int status = myFstatat(dirfd, "Test.txt", &meta_data, 0);
+    myClose(dirfd);
+
+    myUnlink("TestDir/Test.txt");
+    myrmdir("TestDir");
+    return (status == 0 && meta_data.st_size == 5);
 }
 
-//Tests that myStrCpy can copy an empty string
-bool myStrCpyTest2() {
-    char buf[BUF_SIZE];
-    char str[BUF_SIZE] = "";
-    myStrCpy(buf, str, myStrLen(str));
-    return (strEqual(buf, ""));
+//Tests that fchmodat changes the permissions of an open directory through "."
+bool myFchmodatTest1() {
+    struct stat meta_data;
+    mymkdir("TestDir", 0755);
+    int dirfd = myOpenat(AT_FDCWD, "TestDir", O_RDONLY | O_DIRECTORY, 0);
+    int status = myFchmodat(dirfd, ".", 0700);
+    myClose(dirfd);
+
+    myStat("TestDir", &meta_data);
+    myrmdir("TestDir");
+    return (status == 0 && (meta_data.st_mode & 07777) == 0700);
 }
 
-//Tests that myStrCpy can copy a pathname
-bool myStrCpyTest3() {
-    char buf[BUF_SIZE];
-    char str[BUF_SIZE] = "~/Documents/CS3104/practicals/CS3104-P1-Sysutil";
-    myStrCpy(buf, str, myStrLen(str));
-    return (strEqual(buf, "~/Documents/CS3104/practicals/CS3104-P1-Sysutil"));
+//Tests that a source in another directory is copied into a directory under its own name
+bool mycpTest3() {
+    struct stat src_meta_data;
+    mymkdir("TestDir", 0755);
+    mymkdir("TestCopy", 0755);
+    createTestFile("TestDir/Test.txt", "Hello");
+
+    myStat("TestDir/Test.txt", &src_meta_data);
+    int status = mycp("TestCopy", "TestDir/Test.txt", &src_meta_data);
+    bool copied = fileContains("TestCopy/Test.txt", "Hello");
+
+    myUnlink("TestDir/Test.txt");
+    myUnlink("TestCopy/Test.txt");
+    myrmdir("TestDir");
+    myrmdir("TestCopy");
+    return (status == 0 && copied);
 }
 
-//Tests to make sure that myStrCpy refuses to copy a NULL pointer
-bool myStrCpyTest4() {
-    char buf[BUF_SIZE] = "Original String";
-    char* str = NULL;
-    myStrCpy(buf, str, myStrLen(str));
-    return (strEqual(buf, "Original String"));
+//Tests that myltoa converts 0 and a number larger than an unsigned int
+bool myltoaTest1() {
+    char zero[MAX_LONG_DIGITS + 1];
+    char large[MAX_LONG_DIGITS + 1];
+    myltoa(0, zero);
+    myltoa(5000000000UL, large);
+    return (strEqual(zero, "0") && strEqual(large, "5000000000"));
 }
 
-//Test myStrCpy with some normal test data
-bool myStrLenTest1() {
-    char buf[6] = "Hello";
-    return (myStrLen(buf) == 5);
+//Tests that utimensat sets the modification time of an open file
+bool myUtimensatTest1() {
+    struct stat meta_data;
+    struct timespec times[2] = { { 1000000000, 0 }, { 1000000000, 123 } };
+    int fd = myCreat("Test.txt", 0644);
+    int status = myUtimensat(fd, NULL, times, 0);
+    myFstat(fd, &meta_data);
+    myClose(fd);
+    myUnlink("Test.txt");
+    return (status == 0 && meta_data.st_mtim.tv_sec == 1000000000 && meta_data.st_mtim.tv_nsec == 123);
 }
 
-//Tests myStrLen with an empty string
-bool myStrLenTest2() {
-    char buf[10] = "";
-    return (myStrLen(buf) == 0);
+//Tests that files with the same contents hash the same and files that differ by a byte do not
+bool hashFileTest1() {
+    bool ok1, ok2, ok3;
+    createTestFile("Test.txt", "Hello World!");
+    createTestFile("Test2.txt", "Hello World!");
+    createTestFile("Test3.txt", "Hello World?");
+
+    int fd1 = myOpen("Test.txt", O_RDONLY);
+    int fd2 = myOpen("Test2.txt", O_RDONLY);
+    int fd3 = myOpen("Test3.txt", O_RDONLY);
+    unsigned long hash1 = hashFile(fd1, &ok1);
+    unsigned long hash2 = hashFile(fd2, &ok2);
+    unsigned long hash3 = hashFile(fd3, &ok3);
+    myClose(fd1);
+    myClose(fd2);
+    myClose(fd3);
+
+    myUnlink("Test.txt");
+    myUnlink("Test2.txt");
+    myUnlink("Test3.txt");
+    return (ok1 && ok2 && ok3 && hash1 == hash2 && hash1 != hash3);
 }
 
-//Tests myStrLen with NULL
-bool myStrLenTest3() {
-    char* buf = NULL;
-    return (myStrLen(buf) == -1);
+/*Tests that a destination with the same size and time is unchanged with
+--update but not with --update=checksum if its contents differ*/
+bool isUnchangedTest1() {
+    struct stat src_meta_data;
+    struct timespec times[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    createTestFile("Source.txt", "Hello");
+    createTestFile("Dest.txt", "Jello");
+    int fd = myOpen("Source.txt", O_RDONLY);
+    myUtimensat(fd, NULL, times, 0);
+    myClose(fd);
+    fd = myOpen("Dest.txt", O_RDONLY);
+    myUtimensat(fd, NULL, times, 0);
+    myClose(fd);
+
+    myStat("Source.txt", &src_meta_data);
+    struct fileRef src = { AT_FDCWD, "Source.txt", "Source.txt" };
+    struct fileRef dest = { AT_FDCWD, "Dest.txt", "Dest.txt" };
+    options.update = UPDATE_MTIME;
+    bool sameTime = isUnchanged(&dest, &src, &src_meta_data);
+    options.update = UPDATE_CHECKSUM;
+    bool sameContents = isUnchanged(&dest, &src, &src_meta_data);
+    options.update = UPDATE_NONE;
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (sameTime && !sameContents);
 }
 
-//Tests that myStat returns 0 for a valid file
-bool myStatTest1() {
-    struct stat meta_data;
-    int status = myStat("mycp.c", &meta_data);
-    return (status == 0);
+//Tests that --update copies a file once, skips it when unchanged, and copies it again once changed
+bool updateTest1() {
+    struct stat src_meta_data;
+    struct copyStats oldStats = stats;
+    options.update = UPDATE_MTIME;
+
+    createTestFile("Source.txt", "Hello");
+    myStat("Source.txt", &src_meta_data);
+    mycp("Dest.txt", "Source.txt", &src_meta_data);
+    mycp("Dest.txt", "Source.txt", &src_meta_data);
+    bool skipped = (stats.filesCopied == oldStats.filesCopied + 1 && stats.filesSkipped == oldStats.filesSkipped + 1
+        && stats.bytesSkipped == oldStats.bytesSkipped + 5);
+
+    createTestFile("Source.txt", "Hello World!");
+    myStat("Source.txt", &src_meta_data);
+    mycp("Dest.txt", "Source.txt", &src_meta_data);
+    bool copied = (stats.filesCopied == oldStats.filesCopied + 2) && fileContains("Dest.txt", "Hello World!");
+
+    options.update = UPDATE_NONE;
+    stats = oldStats;
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (skipped && copied);
 }
 
-//Tests that myStat returns an error number for a NULL file pointer
-bool myStatTest2() {
-    struct stat meta_data;
-    int status = myStat(NULL, &meta_data);
-    return (status != 0);
+//Tests that pwrite and pread write and read at an offset without moving the file offset
+bool myPreadTest1() {
+    char buf[6] = { 0 };
+    createTestFile("Test.txt", "Hello World!");
+    int fd = myOpen("Test.txt", O_RDWR);
+    long written = myPwrite(fd, "There", 5, 6);
+    long bytesRead = myPread(fd, buf, 5, 6);
+    off_t offset = myLseek(fd, 0, SEEK_CUR);
+    myClose(fd);
+
+    bool equal = fileContains("Test.txt", "Hello There!");
+    myUnlink("Test.txt");
+    return (written == 5 && bytesRead == 5 && strEqual(buf, "There") && offset == 0 && equal);
 }
 
-//Tests that myStat returns an error number for a non-existent file
-bool myStatTest3() {
-    struct stat meta_data;
-    int status = myStat("Non-existent file", &meta_data);
-    return (status != 0);
+//Tests that chunksEqual finds a difference in the vector part and in the tail of a buffer
+bool chunksEqualTest1() {
+    char a[200];
+    char b[200];
+    for (int i = 0; i < 200; i++) a[i] = b[i] = (char) i;
+    bool equal = chunksEqual(a, b, 200);
+
+    b[70] = 0;
+    bool vectorDiffers = !chunksEqual(a, b, 200) && chunksEqual(a, b, 70);
+    b[70] = a[70];
+    b[199] = 0;
+    bool tailDiffers = !chunksEqual(a, b, 200) && chunksEqual(a + 1, b + 1, 198);
+
+    return (equal && vectorDiffers && tailDiffers);
 }
 
-//Tests that valid file opens successfully for read only
-bool myOpenTest1() {
-    int fd = myOpen("mycp.c", O_RDONLY);
+/*Writes a test file of numChunks chunks of DELTA_CHUNK_SIZE bytes, each filled
+with fill plus the number of the chunk*/
+bool createChunkFile(char* fileName, int numChunks, char fill) {
+    char chunk[DELTA_CHUNK_SIZE];
+    int fd = myCreat(fileName, 0644);
+    if (fd < 0) return false;
+    for (int i = 0; i < numChunks; i++) {
+        for (int j = 0; j < DELTA_CHUNK_SIZE; j++) chunk[j] = fill + i;
+        writeAll(fd, chunk, DELTA_CHUNK_SIZE);
+    }
     myClose(fd);
-    return (fd != -1);
+    return true;
 }
 
-//Tests that invalid file failes to open successfully and return positive fd
-bool myOpenTest2() {
-    int fd = myOpen("Non-existent file", O_RDONLY);
+/*Tests that deltaCopy only writes the chunk of dest that differs from src, and
+removes the end of a longer dest*/
+bool deltaCopyTest1() {
+    struct stat src_meta_data;
+    createChunkFile("Source.txt", 4, 'a');
+    createChunkFile("Dest.txt", 5, 'a');
+
+    //Changes the third chunk of dest
+    int fd = myOpen("Dest.txt", O_RDWR);
+    myPwrite(fd, "X", 1, 2 * DELTA_CHUNK_SIZE + 100);
     myClose(fd);
-    return (fd < 0);
+
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myOpen("Dest.txt", O_RDWR);
+    myFstat(src, &src_meta_data);
+    struct copyFile file;
+    initCopyFile(&file, dest, src, &src_meta_data);
+    long written = deltaCopy(&file, src_meta_data.st_size);
+    freeCopyFile(&file);
+
+    //Checks the contents of dest match src
+    char srcBuf[4 * DELTA_CHUNK_SIZE];
+    char destBuf[4 * DELTA_CHUNK_SIZE];
+    struct stat dest_meta_data;
+    myFstat(dest, &dest_meta_data);
+    bool equal = readFullAt(src, srcBuf, sizeof(srcBuf), 0) == (long) sizeof(srcBuf)
+        && readFullAt(dest, destBuf, sizeof(destBuf), 0) == (long) sizeof(destBuf)
+        && chunksEqual(srcBuf, destBuf, sizeof(srcBuf));
+    myClose(src);
+    myClose(dest);
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (written == DELTA_CHUNK_SIZE && equal && dest_meta_data.st_size == 4 * DELTA_CHUNK_SIZE);
 }
 
-//Tests that valid open file is closed successfully
-bool myCloseTest1() {
-    int fd = myOpen("mycp.c", O_RDONLY);
-    int status =  myClose(fd);
-    return (status == 0);
+//Tests that deltaCopy writes the part of src beyond the end of a shorter dest
+bool deltaCopyTest2() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello World!");
+    createTestFile("Dest.txt", "Hello");
+
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myOpen("Dest.txt", O_RDWR);
+    myFstat(src, &src_meta_data);
+    struct copyFile file;
+    initCopyFile(&file, dest, src, &src_meta_data);
+    long written = deltaCopy(&file, src_meta_data.st_size);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+
+    bool equal = fileContains("Dest.txt", "Hello World!");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (written == 12 && equal);
 }
 
-//Tests that unopened file cannot be closes successfully
-bool myCloseTest2() {
-    int fd = myOpen("Non-existent file", O_RDONLY);
-    int status = myClose(fd);
-    return (status != 0);
+//Tests that mycp with --delta keeps an existing destination and makes it equal to the source
+bool deltaTest1() {
+    struct stat src_meta_data;
+    struct stat before;
+    struct stat after;
+    options.delta = true;
+
+    createTestFile("Source.txt", "Hello World!");
+    createTestFile("Dest.txt", "Hello There! And more");
+    myStat("Dest.txt", &before);
+    myStat("Source.txt", &src_meta_data);
+    int status = mycp("Dest.txt", "Source.txt", &src_meta_data);
+    myStat("Dest.txt", &after);
+    options.delta = false;
+
+    bool equal = fileContains("Dest.txt", "Hello World!");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (status == 0 && equal && before.st_ino == after.st_ino);
 }
 
-//Tests that zero bytes are written for empty string
-bool myWriteTest1() {
-    char buf[BUF_SIZE] = "";
-    int bytesWritten = myWrite(stdout, buf, myStrLen(buf));
-    return (bytesWritten == 0);
+//Tests that crc32c gives the standard check value of CRC32C for "123456789"
+bool crc32cTest1() {
+    return (crc32c(0, "123456789", 9) == 0xE3069283 && crc32c(0, "", 0) == 0);
 }
 
-//Tests that valid positive number of bytes are written for string
-bool myWriteTest2() {
-    char buf[BUF_SIZE] = "\n~/Documents/CS3104/practicals/CS3104-P1-Sysutil\n";
-    int bytesWritten = myWrite(stdout, buf, myStrLen(buf));
-    return (bytesWritten == myStrLen(buf));
+//Tests that a checksum computed in parts, of unaligned lengths, equals the checksum of the whole
+bool crc32cTest2() {
+    char buf[1000];
+    for (int i = 0; i < 1000; i++) buf[i] = (char) (i * 7);
+    unsigned int whole = crc32c(0, buf, 1000);
+    unsigned int parts = crc32c(crc32c(crc32c(0, buf, 3), buf + 3, 500), buf + 503, 497);
+    return (whole == parts);
 }
 
-//Tests that error code is returned when trying to write NULL string
-bool myWriteTest3() {
-    char* buf = NULL;
-    int bytesWritten = myWrite(stdout, buf, myStrLen(buf));
-    return (bytesWritten < 0);
+//Tests that the lookup table gives the same checksums as the crc32 instruction, if the CPU has it
+bool crc32cTableTest1() {
+    char buf[1000];
+    for (int i = 0; i < 1000; i++) buf[i] = (char) (i * 13);
+    crc32c(0, "", 0);
+
+    bool check = (~crc32cTable(~0U, "123456789", 9) == 0xE3069283);
+    bool same = !crcHardware || crc32cTable(~0U, buf + 1, 999) == crc32cHardware(~0U, buf + 1, 999);
+    return (check && same);
 }
 
-//Tests that new file can be created successfully
-bool myCreatTest1() {
-    int fd = myCreat("NewFile.txt", O_RDONLY);
-    myUnlink("NewFile.txt");
-    return (fd > 0);
+//Tests that verifyCopy accepts an equal copy and finds a copy that differs by a byte
+bool verifyCopyTest1() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello World!");
+    createTestFile("Dest.txt", "Hello World!");
+    createTestFile("Dest2.txt", "Hello World?");
+
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myOpen("Dest.txt", O_RDONLY);
+    int dest2 = myOpen("Dest2.txt", O_RDONLY);
+    myFstat(src, &src_meta_data);
+    struct copyFile file;
+    initCopyFile(&file, dest, src, &src_meta_data);
+    int equal = verifyCopy(&file, src_meta_data.st_size);
+    file.dest = dest2;
+    int differ = verifyCopy(&file, src_meta_data.st_size);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+    myClose(dest2);
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    myUnlink("Dest2.txt");
+    return (equal == 0 && differ == ERRVERIFY);
 }
 
-//Tests that error is returned when file name is NULL
-bool myCreatTest2() {
-    int fd = myCreat(NULL, O_RDONLY);
-    return (fd < 0);
+//Tests that the rw engine checksums the data it copies, which mycp --verify then checks
+bool verifyTest1() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello World!");
+    myStat("Source.txt", &src_meta_data);
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myCreat("Dest.txt", 0644);
+
+    options.verify = true;
+    struct copyFile file;
+    initCopyFile(&file, dest, src, &src_meta_data);
+    long copied = readWriteEngine(&file, -1);
+    bool checksummed = (file.crcLen == copied && file.crc == crc32c(0, "Hello World!", 12));
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
+
+    int status = mycp("Dest.txt", "Source.txt", &src_meta_data);
+    options.verify = false;
+
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (checksummed && status == 0);
 }
 
-//Tests that file is successfully deleted
-bool myUnlinkTest1() {
-    myCreat("NewFile.txt", O_RDONLY);
-    int status = myUnlink("NewFile.txt");
-    return (status == 0);
+//Tests that an errno is carried by an error flag without changing the flag, and never equals another flag
+bool errorWithErrnoTest1() {
+    int error = errorWithErrno(ERROPEN, ENXIO);
+    return (errorFlag(error) == ERROPEN && errorErrno(error) == ENXIO && error != ERRCLONE
+        && errorFlag(ERRCOPY) == ERRCOPY && errorErrno(ERRCOPY) == 0 && error < 0);
 }
 
-//Tests that error is returned when attempt is made to delete non-existent file
-bool myUnlinkTest2() {
-    int status = myUnlink("Non-existent.txt");
-    return (status < 0);
+//Tests that a source that cannot be opened is reported with the errno of open, not as another flag
+bool copyAtTest1() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello");
+    myStat("Source.txt", &src_meta_data);
+    myUnlink("Source.txt");
+
+    struct fileRef src = { AT_FDCWD, "Source.txt", "Source.txt" };
+    struct fileRef dest = { AT_FDCWD, "Dest.txt", "Dest.txt" };
+    int status = copyAt(&dest, &src, &src_meta_data);
+
+    myUnlink("Dest.txt");
+    return (errorFlag(status) == ERROPEN && errorErrno(status) == ENOENT);
 }
 
-//Tests that directory can be created successfully
-bool myMkdirTest1() {
-    int status = mymkdir("Test Directory", O_RDONLY);
-    myrmdir("Test Directory");
-    return (status == 0);
+//Tests that copying a file onto itself, also with --update and --delta, is refused and leaves it unchanged
+bool copyAtTest2() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello");
+    myStat("Source.txt", &src_meta_data);
+
+    int status = mycp("Source.txt", "Source.txt", &src_meta_data);
+    options.update = UPDATE_CHECKSUM;
+    options.delta = true;
+    int statusOptions = mycp("Source.txt", "Source.txt", &src_meta_data);
+    options.update = UPDATE_NONE;
+    options.delta = false;
+
+    bool unchanged = fileContains("Source.txt", "Hello");
+    myUnlink("Source.txt");
+    return (status == ERRSAME && statusOptions == ERRSAME && unchanged);
 }
 
-//Tests that error is returned for invalid directory creation
-bool myMkdirTest2() {
-    int status = mymkdir(NULL, O_RDONLY);
-    return (status < 0);
+//Tests that a destination in a directory that does not exist is reported with the errno of open
+bool copyAtTest3() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello");
+    myStat("Source.txt", &src_meta_data);
+
+    int status = mycp("Missing/Dest.txt", "Source.txt", &src_meta_data);
+
+    myUnlink("Source.txt");
+    return (errorFlag(status) == ERRCREATE && errorErrno(status) == ENOENT);
 }
 
-//Tests that empty directory can be successfully deleted
-bool myRmdirTest1() {
-    mymkdir("Test Directory", O_RDONLY);
-    int status = myrmdir("Test Directory");
-    return (status == 0);
+/*Tests that -r recreates a FIFO and symlinks rather than reading them, so a FIFO
+and a link back to the tree do not stop the copy*/
+bool copyTreeTest3() {
+    struct stat fifo_meta_data;
+    struct stat link_meta_data;
+    char target[BUF_SIZE];
+    mymkdir("TestDir", 0755);
+    createTestFile("TestDir/a.txt", "a");
+    myMknodat(AT_FDCWD, "TestDir/fifo", S_IFIFO | 0644, 0);
+    mySymlinkat("a.txt", AT_FDCWD, "TestDir/link");
+    mySymlinkat(".", AT_FDCWD, "TestDir/loop");
+
+    options.recursive = true;
+    int status = copySource("TestCopy", "TestDir");
+    options.recursive = false;
+
+    bool fifo = myFstatat(AT_FDCWD, "TestCopy/fifo", &fifo_meta_data, AT_SYMLINK_NOFOLLOW) == 0
+        && S_ISFIFO(fifo_meta_data.st_mode);
+    long len = myReadlinkat(AT_FDCWD, "TestCopy/link", target, BUF_SIZE);
+    bool link = len == 5 && myFstatat(AT_FDCWD, "TestCopy/loop", &link_meta_data, AT_SYMLINK_NOFOLLOW) == 0
+        && S_ISLNK(link_meta_data.st_mode);
+    if (len >= 0) target[len] = '\0';
+    link = link && strEqual(target, "a.txt") && fileContains("TestCopy/link", "a");
+
+    char* files[8] = { "TestDir/a.txt", "TestDir/fifo", "TestDir/link", "TestDir/loop",
+        "TestCopy/a.txt", "TestCopy/fifo", "TestCopy/link", "TestCopy/loop" };
+    for (int i = 0; i < 8; i++) myUnlink(files[i]);
+    myrmdir("TestDir");
+    myrmdir("TestCopy");
+
+    return (status == 0 && fifo && link);
 }
 
-//Tests that non-empty directory cannot be deleted
-bool myRmdirTest2() {
-    //Gives permissiosn in order to be able to delete file
-    mymkdir("TestDirectory", 0775);
-    int fd = myCreat("TestDirectory/NewFile.txt", O_RDONLY);
-    myClose(fd);
-    int status = myrmdir("TestDirectory");
+/*Tests that data spliced from a stream into the pipe is still written when dest
+does not accept splice, as an O_APPEND file does not*/
+bool spliceEngineTest3() {
+    struct stat src_meta_data;
+    createTestFile("Source.txt", "Hello World!");
+    int src = myOpen("Source.txt", O_RDONLY);
+    int dest = myOpenat(AT_FDCWD, "Dest.txt", O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    myFstat(src, &src_meta_data);
 
-    //Clean up
-    myUnlink("TestDirectory/NewFile.txt");
-    myrmdir("TestDirectory");
+    //Reads the source as a stream so that it goes through the pipe
+    struct copyFile file;
+    initCopyFile(&file, dest, src, &src_meta_data);
+    file.stream = true;
+    long copied = spliceEngine(&file, -1);
+    freeCopyFile(&file);
+    myClose(src);
+    myClose(dest);
 
-    return (status < 0);
+    bool equal = fileContains("Dest.txt", "Hello World!");
+    myUnlink("Source.txt");
+    myUnlink("Dest.txt");
+    return (copied == 12 && equal);
+}
+
+/*Tests that reading a directory pushes its files in batches for any worker to
+copy, and that its copy is finished once the last batch has been copied*/
+bool copyDirTest1() {
+    struct treeCopy tree;
+    struct treeWorker* worker = &tree.workers[0];
+    struct treeTask task;
+    struct stat meta_data;
+    char name[BUF_SIZE];
+    char numStr[MAX_INT_DIGITS + 1];
+
+    mymkdir("TestDir", 0555 | S_IWUSR);
+    mymkdir("TestCopy", 0755);
+    for (int i = 0; i < 2 * FILE_BATCH_SIZE + 1; i++) {
+        myitoa(i, numStr);
+        joinPath(name, "TestDir", numStr);
+        createTestFile(name, numStr);
+    }
+
+    tree.numWorkers = 1;
+    tree.pending = 0;
+    tree.idle = 0;
+    tree.destDev = 0;
+    tree.destIno = 0;
+    pthread_mutex_init(&tree.lock, NULL);
+    worker->tree = &tree;
+    worker->id = 0;
+    worker->deque.tasks = NULL;
+    worker->deque.capacity = 0;
+    worker->deque.top = 0;
+    worker->deque.bottom = 0;
+    pthread_mutex_init(&worker->deque.lock, NULL);
+    worker->arena.block = NULL;
+    worker->arena.used = 0;
+
+    //Reads the directory, leaving three batches of files in the deque
+    task.type = TASK_DIR;
+    task.src = "TestDir";
+    task.dest = "TestCopy";
+    copyDir(worker, &task);
+    long batches = tree.pending;
+    myStat("TestCopy", &meta_data);
+    bool writable = (meta_data.st_mode & 07777) == 0755;
+
+    //Copies the batches, oldest first as a thief would
+    while (popTask(&worker->deque, &task, true)) {
+        for (int i = 0; i < task.count; i++) copyEntry(task.dir, task.names[i]);
+        releaseDir(task.dir);
+    }
+    myStat("TestCopy", &meta_data);
+    bool finished = (meta_data.st_mode & 07777) == (0555 | S_IWUSR);
+
+    bool copied = true;
+    for (int i = 0; i < 2 * FILE_BATCH_SIZE + 1; i++) {
+        myitoa(i, numStr);
+        joinPath(name, "TestCopy", numStr);
+        copied = copied && fileContains(name, numStr);
+        myUnlink(name);
+        joinPath(name, "TestDir", numStr);
+        myUnlink(name);
+    }
+    myrmdir("TestDir");
+    myrmdir("TestCopy");
+
+    if (worker->deque.tasks != NULL) myMunmap(worker->deque.tasks, worker->deque.capacity * sizeof(struct treeTask));
+    pthread_mutex_destroy(&worker->deque.lock);
+    pthread_mutex_destroy(&tree.lock);
+    arenaFree(&worker->arena);
+    return (batches == 3 && writable && finished && copied);
+}
+
+//Tests that an empty regular file is not copied as a stream, and that its copy is empty
+bool mycpTest4() {
+    struct stat src_meta_data;
+    struct stat dest_meta_data;
+    struct copyFile file;
+    createTestFile("Test.txt", "");
+    myStat("Test.txt", &src_meta_data);
+
+    int dest = myCreat("Dest.txt", 0644);
+    initCopyFile(&file, dest, -1, &src_meta_data);
+    bool stream = file.stream;
+    freeCopyFile(&file);
+    myClose(dest);
+
+    createTestFile("Dest.txt", "Hello");
+    int status = mycp("Dest.txt", "Test.txt", &src_meta_data);
+    myStat("Dest.txt", &dest_meta_data);
+
+    myUnlink("Test.txt");
+    myUnlink("Dest.txt");
+    return (!stream && status == 0 && dest_meta_data.st_size == 0);
 }
@@ -6,15 +6,26 @@
 #include <time.h>
 #include <dirent.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
 
 // A complete list of linux system call numbers can be found in: /usr/include/asm/unistd_64.h
 //Defines system call numbers for system calls used in the solution
 #define WRITE_SYSCALL 1
 #define STAT_SYSCALL 4
 #define OPEN_SYSCALL 2
-#define GETDENTS_SYSCALL 78
+#define GETDENTS64_SYSCALL 217
 #define TIME_SYSCALL 201
 #define CLOSE_SYSCALL 3
+#define MMAP_SYSCALL 9
+#define MUNMAP_SYSCALL 11
+#define NEWFSTATAT_SYSCALL 262
+#define STATX_SYSCALL 332
+#define IO_URING_SETUP_SYSCALL 425
+#define IO_URING_ENTER_SYSCALL 426
+#define IO_URING_REGISTER_SYSCALL 427
 
 //Defines system call numbers used for unit tests
 #define CREAT_SYSCALL 85
@@ -31,6 +42,10 @@ not exist*/
 a char[] buffer that is used to store a string representation of an integer*/
 #define MAX_INT_DIGITS 10
 
+/*Maximum number of digits used to represent an unsigned 64-bit integer is 20.
+Used for file sizes, numbers of hard links and inode numbers*/
+#define MAX_LONG_DIGITS 20
+
 /*Defines the number required to convert from an integer representation of a
 number to the ASCII code of that number.*/
 #define ASCII_CONVERSION_INT 48
@@ -41,12 +56,101 @@ number to the ASCII code of that number.*/
 //Defines the year that localtime starts counting from for printing purposes (e.g. 1955 is stored as 55)
 #define STARTING_YEAR 1900
 
+//Number of seconds in a day and in an hour, used to derive times within a cached day
+#define SECS_PER_DAY 86400
+#define SECS_PER_HOUR 3600
+#define SECS_PER_MIN 60
+
 //Defines upperbound of single digits for formatting check when printing time
 #define SINGLE_DIGIT 9
 
+/*Default size of the buffer passed to getdents (256 KiB). A larger buffer means
+fewer getdents calls per directory. Can be changed with --bufsize=<KiB>*/
+#define DEFAULT_DIRENT_BUF_SIZE (256 * 1024)
+
+/*Smallest and largest getdents buffers accepted on the command line (in KiB).
+getdents64 returns the number of bytes read as an int, so the buffer is kept
+below 2 GiB*/
+#define MIN_DIRENT_BUF_KIB 4
+#define MAX_DIRENT_BUF_KIB (__INT_MAX__ / KIB)
+
+//Number of bytes in a KiB, used to convert --bufsize argument
+#define KIB 1024
+
+/*Size of the buffer that output is gathered in before being written to stdout
+(64 KiB). Output is only written when the buffer is full or the program ends*/
+#define OUT_BUF_SIZE (64 * 1024)
+
+//std streams
+#define STDOUT 1
+#define STDERR 2
+
+/*Fields of a file's meta data requested from statx. Only the fields printed by
+ls -n are requested so filesystems do not have to fetch anything else. The
+inode number is added by statxMask when -i is given*/
+#define STATX_LS_MASK (STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_SIZE | STATX_MTIME)
+
+/*Smallest record returned by getdents64 (header plus a one character name,
+aligned to 8 bytes). Used to size the array of entries read in one batch*/
+#define MIN_DIRENT64_RECLEN 24
+
+//Number of statx requests that can be queued in the io_uring submission queue at once
+#define URING_QUEUE_DEPTH 256
+
+//Engines used to get the meta data of a batch of directory entries
+#define ENGINE_SEQUENTIAL 0
+#define ENGINE_URING 1
+#define ENGINE_THREADS 2
+
+//Maximum number of threads in the stat worker pool
+#define MAX_THREADS 64
+
 //Defines number of digits in a file's permissions
 #define NUM_PERMISSIONS 9
 
+//Number of permission strings in the lookup table, one for each value of the 9 permission bits
+#define NUM_PERM_STRINGS 512
+
+//Mask of the permission bits of a file mode
+#define PERM_MASK 0777
+
+/*Longest row printed by formatRow, not including the file name: inode,
+directory character, permissions, four integers, time and the spaces between them*/
+#define MAX_ROW_LENGTH 128
+
+//Number of rows formatted by each formatter in the benchmark
+#define BENCH_ROWS 1000000
+
+//Number of nanoseconds in a second, used to compute rows per second in the benchmark
+#define NSECS_PER_SEC 1000000000L
+
+//Pairs of digits from "00" to "99", used to convert integers two digits at a time
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*Powers of 10 from 10^1 to 10^19, used to count the digits of a 64-bit
+integer before converting it*/
+static const unsigned long POWERS_OF_10[MAX_LONG_DIGITS - 1] = {
+    10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL,
+    1000000000UL, 10000000000UL, 100000000000UL, 1000000000000UL, 10000000000000UL,
+    100000000000000UL, 1000000000000000UL, 10000000000000000UL, 100000000000000000UL,
+    1000000000000000000UL, 10000000000000000000UL
+};
+
+//Month strings followed by a space, indexed using month integer returned by localtime
+static const char MONTH_SPACE_STRING[12][MONTH_LENGTH + 1] = {
+    "Jan ", "Feb ", "Mar ", "Apr ", "May ", "Jun ", "Jul ", "Aug ", "Sep ", "Oct ", "Nov ", "Dec "
+};
+
 //Defines list of month strings which are indexed using month integer returned by localtime
 static const char *MONTH_STRING[] = {
     "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
@@ -58,21 +162,132 @@ static const char *MONTH_STRING[] = {
 #define WHITE   "\033[39m"
 
 //Defines number of tests to be run by test suite
-#define NUM_TESTS 43
-
-//Directory entry Struct from getdents man page
-struct linux_dirent {
-    unsigned long  d_ino;     /* Inode number */
-    unsigned long  d_off;     /* Offset to next linux_dirent */
-    unsigned short d_reclen;  /* Length of this linux_dirent */
+#define NUM_TESTS 77
+
+//Directory entry Struct from getdents64 man page
+struct linux_dirent64 {
+    unsigned long  d_ino;     /* 64-bit inode number */
+    long           d_off;     /* 64-bit offset to next structure */
+    unsigned short d_reclen;  /* Size of this dirent */
+    unsigned char  d_type;    /* File type */
     char           d_name[];  /* Filename (null-terminated) */
-                      /* length is actually (d_reclen - 2 -
-                         offsetof(struct linux_dirent, d_name)) */
 };
 
+//Options selected on the command line
+struct lsOptions {
+    bool stats;                   //Print system call statistics to stderr after listing
+    bool bench;                   //Run the row formatting benchmark
+    bool inode;                   //Print the inode number of each file
+    bool namesOnly;               //Print only type character and name, without calling stat
+    bool dontSync;                //Pass AT_STATX_DONT_SYNC to statx to use cached attributes
+    int engine;                   //Engine used to get meta data of directory entries
+    int numThreads;               //Number of threads in the stat worker pool
+    unsigned long direntBufSize;  //Size of buffer passed to getdents in bytes
+};
+
+//Counters printed in stats mode
+struct lsStats {
+    unsigned long getdentsCalls;  //Number of getdents system calls made
+    unsigned long entries;        //Number of directory entries read
+    unsigned long statCalls;      //Number of stat system calls made
+    unsigned long writeCalls;     //Number of write system calls made
+    unsigned long uringEnterCalls; //Number of io_uring_enter system calls made
+};
+
+//A directory entry read by getdents64 along with its meta data
+struct dirEntry {
+    char* name;                   //Name of file, points into the getdents buffer
+    unsigned char type;           //d_type of file
+    bool needsStat;               //Whether meta data must be fetched for this entry
+    int status;                   //Status code returned when fetching meta data
+    /*Meta data of file. io_uring fills in stx, which is then converted to
+    meta_data in place, so each entry only holds one of them*/
+    union {
+        struct stat meta_data;
+        struct statx stx;
+    };
+};
+
+//Submission and completion queues shared with the kernel by io_uring
+struct uringQueue {
+    int fd;                       //File descriptor returned by io_uring_setup
+    unsigned int sqEntries;       //Number of entries in the submission queue
+    unsigned int* sqHead;
+    unsigned int* sqTail;
+    unsigned int* sqMask;
+    unsigned int* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int* cqMask;
+    struct io_uring_cqe* cqes;
+    void* sqRing;                 //Mappings of the rings and their sizes, used to unmap them
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+};
+
+/*Fixed size pool of threads that get the meta data of a batch of entries in
+parallel. Workers take the index of the next entry from a shared counter and
+write its meta data into the batch's entry array, so entries are printed in
+the order getdents returned them.*/
+struct statPool {
+    pthread_t threads[MAX_THREADS];
+    int numThreads;
+    pthread_mutex_t lock;
+    pthread_cond_t workReady;     //Signalled when a new batch is published or on shutdown
+    pthread_cond_t workDone;      //Signalled when every worker has finished the batch
+    long dirfd;                   //Directory containing the entries of the batch
+    struct dirEntry* entries;     //Entries of the current batch
+    int numEntries;
+    int next;                     //Index of next entry to stat, taken atomically
+    int finished;                 //Number of workers finished with the current batch
+    unsigned long batch;          //Number of batches published, used to wake workers
+    bool shutdown;
+};
+
+/*Cached results of localtime used by printModifiedTime. The current year is
+found once per run, and the local date of one span of time (normally a whole
+day) is kept so that times inside it are converted with integer arithmetic.*/
+struct timeCache {
+    bool initialised;
+    int currentYear;              //Current year, e.g. 2018
+    time_t start;                 //First second covered by the cached span
+    time_t end;                   //First second after the cached span
+    struct tm startTime;          //Local time of start
+};
+
+static struct timeCache timeCache;
+
+/*Lookup table of permission strings (e.g. "rwxr-xr-x") indexed by the 9
+permission bits of a file mode. Filled in by initFormatTables*/
+static char permTable[NUM_PERM_STRINGS][NUM_PERMISSIONS];
+
+//Buffer that all output to stdout is gathered in, and number of bytes in it
+static char outBuf[OUT_BUF_SIZE];
+static size_t outLen;
+
+static struct lsOptions options = { false, false, false, false, false, ENGINE_SEQUENTIAL, 1, DEFAULT_DIRENT_BUF_SIZE };
+
+//Set once statx is found to be unsupported by the kernel, after which fstatat is used
+static bool statxUnsupported;
+static struct lsStats stats;
+
+//Set once an error has been printed, so that myls exits with status 1
+static bool failed;
+
 //Headers for system call wrapper functions containing inline assembly
 int myStat(char* fileName, struct stat* meta_data);
+int myFstatAt(long dirfd, char* fileName, struct stat* meta_data, int flags);
+int myStatx(long dirfd, char* fileName, int flags, unsigned int mask, struct statx* meta_data);
+int myIoUringSetup(unsigned int entries, struct io_uring_params* params);
+int myIoUringEnter(long fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags);
+int myIoUringRegister(long fd, unsigned int opcode, void* arg, unsigned int numArgs);
 int myWrite(char* str);
+int myWriteFd(long fd, char* str, size_t len);
+void* myMmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+int myMunmap(void* addr, size_t length);
 int myGetDents(long fd, char* buf, unsigned long bufferSize);
 int myOpen(char* fileName, mode_t mode);
 int myClose(long fd);
@@ -82,17 +297,28 @@ int myUnlink(const char* pathname);
 int myrmdir(const char* pathname);
 int mymkdir(const char* pathname, mode_t mode);
 
+//Functions to gather output in outBuf and write it to stdout
+void myPrint(char* str);
+void myPrintN(char* str, size_t len);
+int flushOutput();
+int writeAll(int fd, char* buf, size_t count);
+
 //Custom implementations of useful string functions
 int myStrLen(char* str);
 void myStrCpy(char* dest, const char* src, size_t n);
+void myMemCpy(char* dest, const char* src, size_t n);
 bool strEqual(char* str1, char* str2);
 void myitoa(unsigned int num, char* str);
+void myltoa(unsigned long num, char* str);
+bool strPrefix(char* str, char* prefix);
+long myatoi(char* str);
 
 //Given an integer month (0-11), populates monthStr with a string month
 void monthToStr(unsigned int month, char* monthStr);
 
-//Writes error message to stdout if stat fails on a filename
-void writeErrorMsg(char* fileName);
+//Writes error message to stdout if stat, open or getdents fails on a filename
+void writeErrorMsg(char* fileName, int err);
+char* errnoMessage(int err);
 
 //Given a stat struct, populates a char* with file permissions of a file
 void getFilePerm(struct stat meta_data, char* filePerm);
@@ -101,12 +327,62 @@ void getFilePerm(struct stat meta_data, char* filePerm);
 file is a directory or not */
 void getDirChar(struct stat meta_data, char* dir);
 
+/*Given a d_type returned by getdents64, populates a char* with a character
+signifying whether a file is a directory or not*/
+void getDirCharFromType(unsigned char type, char* dir);
+
+//Prints type character and name of a file on one line
+void printName(char* dir, char* name);
+
+/*Gets the meta data printed by ls -n using statx, falling back to fstatat if
+statx is unsupported*/
+int getMetaData(long dirfd, char* fileName, struct stat* meta_data);
+unsigned int statxMask();
+
+//Copies the fields returned by statx into a stat struct
+void statxToStat(struct statx* stx, struct stat* meta_data);
+
+/*Engines that get the meta data of a batch of directory entries, either one
+stat call at a time or submitted together through io_uring*/
+void statBatchSequential(long dirfd, struct dirEntry* entries, int numEntries);
+int statBatchUring(struct uringQueue* ring, long dirfd, struct dirEntry* entries, int numEntries);
+
+/*Thread pool engine: start and stop the workers and get the meta data of a
+batch of entries using them*/
+int poolInit(struct statPool* pool, int numThreads);
+void poolExit(struct statPool* pool);
+void statBatchPool(struct statPool* pool, long dirfd, struct dirEntry* entries, int numEntries);
+void* poolWorker(void* arg);
+
+/*Set up and tear down an io_uring instance used to submit statx requests, and
+wait for requests still in flight*/
+int uringInit(struct uringQueue* ring, unsigned int entries);
+void uringExit(struct uringQueue* ring);
+void uringDrain(struct uringQueue* ring, int inFlight);
+
 /*Functions to print data about files, including time modified, meta data about
 file, as well as meta data of all files in a directory*/
 void printModifiedTime(struct stat meta_data);
+
+/*Table driven formatter that writes a complete ls -n row directly into the
+output buffer, and the functions it uses*/
+void initFormatTables();
+void formatRow(struct stat* meta_data, char* name);
+char* formatUlong(char* dest, unsigned long num);
+int countDigits(unsigned long num);
+
+//Compares rows per second of printMetaData and formatRow
+void runBenchmark();
+void cachedLocaltime(time_t t, struct tm* result);
 void printMetaData(struct stat meta_data);
 void printDirEntries(char* dirName);
 
+//Parses leading command line options, returns index of first non-option argument
+int parseArgs(int argc, char** argv);
+
+//Prints counters gathered while listing to stderr
+void printStats();
+
 //Functions for unit tests
 int runTests(bool (*testFunctions[]) (), int numTests);
 void initTests(bool (*testFunctions[]) ());
@@ -153,6 +429,41 @@ bool getFilePermTest1();
 bool getFilePermTest2();
 bool getDirCharTest1();
 bool getDirCharTest2();
+bool myMmapTest1();
+bool myMmapTest2();
+bool myMunmapTest1();
+bool strPrefixTest1();
+bool strPrefixTest2();
+bool myatoiTest1();
+bool myatoiTest2();
+bool myatoiTest3();
+bool getDirCharFromTypeTest1();
+bool getDirCharFromTypeTest2();
+bool myGetDentsTest3();
+bool myPrintTest1();
+bool myPrintTest2();
+bool flushOutputTest1();
+bool myFstatAtTest1();
+bool myFstatAtTest2();
+bool myFstatAtTest3();
+bool myStatxTest1();
+bool myStatxTest2();
+bool getMetaDataTest1();
+bool statBatchSequentialTest1();
+bool statBatchUringTest1();
+bool statBatchPoolTest1();
+bool cachedLocaltimeTest1();
+bool cachedLocaltimeTest2();
+bool formatUlongTest1();
+bool formatUlongTest2();
+bool formatUlongTest3();
+bool countDigitsTest1();
+bool myltoaTest1();
+bool myltoaTest2();
+bool formatRowTest3();
+bool formatRowMatches(char* fileName);
+bool formatRowTest1();
+bool formatRowTest2();
 
 /**
 Main function.
@@ -166,43 +477,112 @@ int main(int argc, char** argv)
     //Struct to store meta data of file specified as argument
     struct stat meta_data;
 
+    //Gets index of file argument after any options
+    int argIndex = parseArgs(argc, argv);
+    if (argIndex < 0) return 1;
+
+    initFormatTables();
+
     //If file specified, get the file name
-    if (argc == 2) {
+    if (argIndex == argc - 1) {
         /*Gets size of file name, copies file name to buffer, and then calls myStat
         on file name to get file meta data */
-        int size = myStrLen(argv[1]);
+        int size = myStrLen(argv[argIndex]);
         char fileName[BUF_SIZE];
-        myStrCpy(fileName, argv[1], size);
-        int status = myStat(fileName, &meta_data);
-        //If myStat returned successfully then check if file is directory or not
+        myStrCpy(fileName, argv[argIndex], size);
+        int status = getMetaData(AT_FDCWD, fileName, &meta_data);
+        //If getMetaData returned successfully then check if file is directory or not
         if (status == 0) {
             //If file is a directory, then write data about all files in that directory
             if (S_ISDIR(meta_data.st_mode)) {
                 printDirEntries(fileName);
+            } else if (options.namesOnly) {
+                char dir[2];
+                getDirChar(meta_data, dir);
+                printName(dir, fileName);
             } else {
             //Otherwise write data about that file (removing any preceding path)
-                printMetaData(meta_data);
-                myWrite(" ");
-                myWrite(fileName);
-                myWrite("\n");
+                formatRow(&meta_data, fileName);
             }
         //Otherwise write error message to user
         } else {
-            writeErrorMsg(fileName);
+            writeErrorMsg(fileName, status);
         }
+
+        flushOutput();
+        if (options.stats) printStats();
+    //If only --bench is specified then run the formatting benchmark
+    } else if (argIndex == argc && options.bench) {
+        runBenchmark();
     //If no arguments are specified then run unit tests
     } else if (argc == 1) {
         //Creates list of bool functions to store test functions
         bool (*unitTests[NUM_TESTS]) ();
         initTests(unitTests);
         runTests(unitTests, NUM_TESTS);
+        flushOutput();
     }
 
-    return 0;
+    return failed ? 1 : 0;
 }
 
 /**
-Custom wrapper function for getdents system call using inline assembly
+Parses options given before the file argument:
+    --stats          print number of getdents calls and entries read to stderr
+    --bench          with no file, compare rows per second of the row formatters
+    -i               print the inode number of each file
+    --names          print only type character and name of each file
+    --dont-sync      use cached attributes on network filesystems (AT_STATX_DONT_SYNC)
+    --uring          submit the stats of each getdents batch together through io_uring
+    -j <threads>     stat entries in parallel with a pool of threads
+    --bufsize=<KiB>  size of the buffer passed to getdents
+@argc - number of arguments
+@argv - list of arguments
+@return - index of first non-option argument, -1 if an option is invalid
+**/
+int parseArgs(int argc, char** argv) {
+    int i;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strEqual(argv[i], "--stats")) {
+            options.stats = true;
+        } else if (strEqual(argv[i], "--bench")) {
+            options.bench = true;
+        } else if (strEqual(argv[i], "-i")) {
+            options.inode = true;
+        } else if (strEqual(argv[i], "--names")) {
+            options.namesOnly = true;
+        } else if (strEqual(argv[i], "--dont-sync")) {
+            options.dontSync = true;
+        } else if (strEqual(argv[i], "--uring")) {
+            options.engine = ENGINE_URING;
+        } else if (strEqual(argv[i], "-j") && i + 1 < argc) {
+            long threads = myatoi(argv[++i]);
+            if (threads < 1 || threads > MAX_THREADS) {
+                myWriteFd(STDERR, "myls: invalid number of threads\n", myStrLen("myls: invalid number of threads\n"));
+                return -1;
+            }
+            options.engine = ENGINE_THREADS;
+            options.numThreads = threads;
+        } else if (strPrefix(argv[i], "--bufsize=")) {
+            long kib = myatoi(argv[i] + myStrLen("--bufsize="));
+            if (kib < MIN_DIRENT_BUF_KIB || kib > MAX_DIRENT_BUF_KIB) {
+                myWriteFd(STDERR, "myls: invalid buffer size\n", myStrLen("myls: invalid buffer size\n"));
+                return -1;
+            }
+            options.direntBufSize = kib * KIB;
+        } else {
+            myWriteFd(STDERR, "myls: invalid option '", myStrLen("myls: invalid option '"));
+            myWriteFd(STDERR, argv[i], myStrLen(argv[i]));
+            myWriteFd(STDERR, "'\n", 2);
+            return -1;
+        }
+    }
+
+    return i;
+}
+
+/**
+Custom wrapper function for getdents64 system call using inline assembly
 @fd - file descriptor of file to get directory entries
 @buf - buffer to store directory entry data in
 @bufferSize - size of buffer
@@ -210,6 +590,7 @@ Custom wrapper function for getdents system call using inline assembly
 **/
 int myGetDents(long fd, char* buf, unsigned long bufferSize) {
     long ret = -1;
+    stats.getdentsCalls++;
 
     asm( "movq %1, %%rax\n\t"
          "movq %2, %%rdi\n\t"
@@ -218,7 +599,7 @@ int myGetDents(long fd, char* buf, unsigned long bufferSize) {
          "syscall\n\t"
          "movq %%rax, %0\n\t" :
          "=r"(ret) :
-         "r"((long)GETDENTS_SYSCALL), "r"(fd), "r"(buf), "r"(bufferSize) :
+         "r"((long)GETDENTS64_SYSCALL), "r"(fd), "r"(buf), "r"(bufferSize) :
          "%rax","%rdi", "%rsi", "%rdx", "memory" );
 
     return ret;
@@ -232,6 +613,7 @@ Custom wrapper function for stat system call using inline assembly
 **/
 int myStat(char* fileName, struct stat* meta_data) {
     long ret = -1;
+    stats.statCalls++;
 
     asm( "movq %1, %%rax\n\t"
          "movq %2, %%rdi\n\t"
@@ -245,6 +627,139 @@ int myStat(char* fileName, struct stat* meta_data) {
     return ret;
 }
 
+/**
+Custom wrapper function for newfstatat system call using inline assembly.
+Relative file names are resolved from an open directory rather than the
+current directory, so the directory's path is not walked again.
+@dirfd - file descriptor of directory fileName is relative to, or AT_FDCWD
+@fileName - name of file to get meta data about
+@meta_data - struct to store file meta data in
+@flags - AT_* flags, e.g. AT_SYMLINK_NOFOLLOW
+@return - status code
+**/
+int myFstatAt(long dirfd, char* fileName, struct stat* meta_data, int flags) {
+    long ret = -1;
+    __atomic_add_fetch(&stats.statCalls, 1, __ATOMIC_RELAXED);
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)NEWFSTATAT_SYSCALL), "r"(dirfd), "r"(fileName), "r"(meta_data), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for statx system call using inline assembly.
+Only the fields in mask are guaranteed to be filled in.
+@dirfd - file descriptor of directory fileName is relative to, or AT_FDCWD
+@fileName - name of file to get meta data about
+@flags - AT_* flags, e.g. AT_STATX_DONT_SYNC
+@mask - STATX_* fields to request
+@meta_data - struct to store file meta data in
+@return - status code
+**/
+int myStatx(long dirfd, char* fileName, int flags, unsigned int mask, struct statx* meta_data) {
+    long ret = -1;
+    __atomic_add_fetch(&stats.statCalls, 1, __ATOMIC_RELAXED);
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq %6, %%r8\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)STATX_SYSCALL), "r"(dirfd), "r"(fileName), "r"((long)flags),
+         "r"((long)mask), "r"(meta_data) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for io_uring_setup system call using inline assembly
+@entries - number of entries requested for the submission queue
+@params - parameters of the io_uring, filled in with ring offsets by the kernel
+@return - file descriptor of io_uring if successful, negative error number otherwise
+**/
+int myIoUringSetup(unsigned int entries, struct io_uring_params* params) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IO_URING_SETUP_SYSCALL), "r"((long)entries), "r"(params) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for io_uring_enter system call using inline assembly
+@fd - file descriptor of io_uring
+@toSubmit - number of new submission queue entries to submit
+@minComplete - number of completions to wait for if IORING_ENTER_GETEVENTS is set
+@flags - IORING_ENTER_* flags
+@return - number of entries submitted, or negative error number
+**/
+int myIoUringEnter(long fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags) {
+    long ret = -1;
+    stats.uringEnterCalls++;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq $0, %%r8\n\t"
+         "movq $0, %%r9\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IO_URING_ENTER_SYSCALL), "r"(fd), "r"((long)toSubmit),
+         "r"((long)minComplete), "r"((long)flags) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%r9","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Custom wrapper function for io_uring_register system call using inline assembly
+@fd - file descriptor of io_uring
+@opcode - IORING_REGISTER_* operation
+@arg - argument of operation
+@numArgs - number of elements in arg
+@return - status code
+**/
+int myIoUringRegister(long fd, unsigned int opcode, void* arg, unsigned int numArgs) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)IO_URING_REGISTER_SYSCALL), "r"(fd), "r"((long)opcode), "r"(arg), "r"((long)numArgs) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%rcx","%r11","memory" );
+
+    return ret;
+}
+
 /**
 Custom wrapper function for open system call using inline assembly
 @fileName - name of file to open
@@ -291,11 +806,19 @@ Has been simplified to allow for easy printing
 @str - string to be written to stdout
 **/
 int myWrite(char* str) {
-    //Length of string to be printed
-    size_t len = myStrLen(str);
-    //Handle is 1 for stdout
-    long handle = 1;
+    return myWriteFd(STDOUT, str, myStrLen(str));
+}
+
+/**
+Custom wrapper function for write system call using inline assembly
+@fd - stream to write to
+@str - buffer to write from
+@len - number of bytes to write
+@return - number of bytes written, or negative error number
+**/
+int myWriteFd(long fd, char* str, size_t len) {
     long ret = -1;
+    stats.writeCalls++;
 
     asm( "movq %1, %%rax\n\t"
          "movq %2, %%rdi\n\t"
@@ -304,8 +827,120 @@ int myWrite(char* str) {
          "syscall\n\t"
          "movq %%rax, %0\n\t" :
          "=r"(ret) :
-         "r"((long)WRITE_SYSCALL),"r"(handle), "r"(str), "r"(len) :
-         "%rax","%rdi","%rsi","%rdx","memory" );
+         "r"((long)WRITE_SYSCALL),"r"(fd), "r"(str), "r"(len) :
+         "%rax","%rdi","%rsi","%rdx","%rcx","%r11","memory" );
+
+    return ret;
+}
+
+/**
+Adds a string to the output buffer, writing the buffer to stdout first if the
+string does not fit
+@str - string to print
+**/
+void myPrint(char* str) {
+    myPrintN(str, myStrLen(str));
+}
+
+/**
+Adds len bytes to the output buffer, writing the buffer to stdout first if they
+do not fit. Data larger than the buffer is written directly with writeAll.
+@str - bytes to print
+@len - number of bytes to print
+**/
+void myPrintN(char* str, size_t len) {
+    if (outLen + len > OUT_BUF_SIZE) {
+        flushOutput();
+
+        if (len > OUT_BUF_SIZE) {
+            writeAll(STDOUT, str, len);
+            return;
+        }
+    }
+
+    myMemCpy(outBuf + outLen, str, len);
+    outLen += len;
+}
+
+/**
+Writes everything in the output buffer to stdout, retrying partial writes
+@return - 0 if successful, negative error number otherwise
+**/
+int flushOutput() {
+    int ret = writeAll(STDOUT, outBuf, outLen);
+    outLen = 0;
+    return ret;
+}
+
+/**
+Writes count bytes from buf to fd, retrying partial and interrupted writes
+@fd - fd to write to
+@buf - bytes to write
+@count - number of bytes to write
+@return - 0 if successful, negative error number otherwise
+**/
+int writeAll(int fd, char* buf, size_t count) {
+    size_t written = 0;
+
+    while (written < count) {
+        int ret = myWriteFd(fd, buf + written, count - written);
+        if (ret == -EINTR) continue;
+        if (ret < 0) return ret;
+        written += ret;
+    }
+
+    return 0;
+}
+
+/**
+Custom wrapper function for mmap system call using inline assembly
+@addr - hint for address of mapping, or NULL
+@length - length of mapping in bytes
+@prot - memory protection of mapping
+@flags - type of mapping
+@fd - file to map, -1 for anonymous mappings
+@offset - offset into file to map from
+@return - address of mapping, or MAP_FAILED if error occurred
+**/
+void* myMmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "movq %4, %%rdx\n\t"
+         "movq %5, %%r10\n\t"
+         "movq %6, %%r8\n\t"
+         "movq %7, %%r9\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "g"((long)MMAP_SYSCALL), "g"(addr), "g"(length), "g"((long)prot),
+         "g"((long)flags), "g"((long)fd), "g"((long)offset) :
+         "%rax","%rdi","%rsi","%rdx","%r10","%r8","%r9","%rcx","%r11","memory" );
+
+    //Errors are returned as a negative error number in the range -4095 to -1
+    if (ret < 0 && ret > -4096) return MAP_FAILED;
+    return (void*) ret;
+}
+
+/**
+Custom wrapper function for munmap system call using inline assembly
+@addr - address of mapping to remove
+@length - length of mapping in bytes
+@return - 0 if successful, negative error number otherwise
+**/
+int myMunmap(void* addr, size_t length) {
+    long ret = -1;
+
+    asm( "movq %1, %%rax\n\t"
+         "movq %2, %%rdi\n\t"
+         "movq %3, %%rsi\n\t"
+         "syscall\n\t"
+         "movq %%rax, %0\n\t" :
+         "=r"(ret) :
+         "r"((long)MUNMAP_SYSCALL), "r"(addr), "r"(length) :
+         "%rax","%rdi","%rsi","%rcx","%r11","memory" );
 
     return ret;
 }
@@ -410,199 +1045,939 @@ int myrmdir(const char* pathname) {
 }
 
 /**
-Custom implementation of strlen function
-@str - string to get the length of
-@return - length of string not including '\0'
+Custom implementation of strlen function
+@str - string to get the length of
+@return - length of string not including '\0'
+**/
+int myStrLen(char* str) {
+    if (str == NULL) return -1;
+
+    int i;
+    for (i = 0; str[i] != '\0'; i++);
+    return i;
+}
+
+/**
+Custom implementation of strcpy function
+@dest - destination to copy string to
+@src - source to copy string from
+@n - size of string to copy in bytes
+**/
+void myStrCpy(char* dest, const char* src, size_t n) {
+    //If src is NULL then operation is terminated.
+    if (src == NULL) {
+        return;
+    }
+
+    size_t i;
+    for (i = 0; i < n; i++) {
+        dest[i] = src[i];
+    }
+    dest[i] = '\0';
+}
+
+/**
+Custom implementation of memcpy function, unlike myStrCpy no '\0' is appended
+@dest - destination to copy bytes to
+@src - source to copy bytes from
+@n - number of bytes to copy
+**/
+void myMemCpy(char* dest, const char* src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = src[i];
+    }
+}
+
+/**
+Compares two strings for equality - used for unit testing
+@str1 - first string
+@str2 - second string
+return - whether string is equal
+**/
+bool strEqual(char* str1, char* str2) {
+    if (str1 == NULL || str2 == NULL) return (str1 == str2);
+
+    if (myStrLen(str1) != myStrLen(str2)) return false;
+
+    for (int i = 0; str1[i] != '\0'; i++) {
+        if (str1[i] != str2[i]) return false;
+    }
+
+    return true;
+}
+
+/**
+Checks whether a string begins with a given prefix
+@str - string to check
+@prefix - prefix to look for
+@return - whether str begins with prefix
+**/
+bool strPrefix(char* str, char* prefix) {
+    if (str == NULL || prefix == NULL) return false;
+
+    for (int i = 0; prefix[i] != '\0'; i++) {
+        if (str[i] != prefix[i]) return false;
+    }
+
+    return true;
+}
+
+/**
+Custom implementation of atoi function for non-negative integers
+@str - string to convert
+@return - integer value of str, or -1 if str is not a non-negative integer or
+does not fit in a long
+**/
+long myatoi(char* str) {
+    if (str == NULL || str[0] == '\0') return -1;
+
+    long num = 0;
+    for (int i = 0; str[i] != '\0'; i++) {
+        if (str[i] < '0' || str[i] > '9') return -1;
+        if (num > (__LONG_MAX__ - (str[i] - ASCII_CONVERSION_INT)) / 10) return -1;
+        num = num * 10 + (str[i] - ASCII_CONVERSION_INT);
+    }
+
+    return num;
+}
+
+/**
+Custom implementation of itoa function
+@num - positive integer to convert to string
+@str - char* to store converted string
+**/
+void myitoa(unsigned int num, char* str) {
+    char intStr[MAX_INT_DIGITS + 1];
+    int i = 0;
+
+    //Assigns 0 string if num is zero
+    if (num == 0) {
+        str[0] = '0';
+        str[1] = '\0';
+        return;
+    }
+
+    //Gets digits from least to most significant (reverse order in array)
+    while (num) {
+        //Gets least significant bit
+        intStr[i++] = num % 10;
+        //Reduces size of num by factor of 10
+        num /= 10;
+    }
+    intStr[i] = '\0';
+
+    //Converts digits to ASCII and reorders in new array
+    for (int j = 0, k = i - 1; j < i; j++, k--) {
+        str[k] = intStr[j] + ASCII_CONVERSION_INT;
+    }
+
+    str[i] = '\0';
+}
+
+/**
+Converts a 64-bit integer to a string, so that sizes of files over 4 GiB are
+not truncated as they would be by myitoa
+@num - positive integer to convert to string
+@str - char* to store converted string, at least MAX_LONG_DIGITS + 1 long
+**/
+void myltoa(unsigned long num, char* str) {
+    *formatUlong(str, num) = '\0';
+}
+
+/**
+Prints meta data of file in the format of ls -n, one field at a time. Listings
+use formatRow, this is kept as the reference the benchmark compares against.
+@meta_data - meta data of file to print
+**/
+void printMetaData(struct stat meta_data) {
+    char tempStr[BUF_SIZE];
+
+    /* Gets the permissions and directory character of file and prints it using
+    myWrite*/
+    getDirChar(meta_data, tempStr);
+    myPrint(tempStr);
+    getFilePerm(meta_data, tempStr);
+    myPrint(tempStr);
+
+    /*Gets number of hard links, user id, group id, and size, converts all values
+    to strings, and then prints using myWrite*/
+    myPrint(" ");
+    myltoa(meta_data.st_nlink, tempStr);
+    myPrint(tempStr);
+    myPrint(" ");
+    myitoa(meta_data.st_uid, tempStr);
+    myPrint(tempStr);
+    myPrint(" ");
+    myitoa(meta_data.st_gid, tempStr);
+    myPrint(tempStr);
+    myPrint(" ");
+    myltoa(meta_data.st_size, tempStr);
+    myPrint(tempStr);
+    myPrint(" ");
+
+    //Prints the time the file was last modified
+    printModifiedTime(meta_data);
+}
+
+/**
+Fills in the permission string lookup table used by formatRow, with one entry
+for each combination of the 9 permission bits
+**/
+void initFormatTables() {
+    const char* letters = "rwxrwxrwx";
+
+    for (int mode = 0; mode < NUM_PERM_STRINGS; mode++) {
+        for (int bit = 0; bit < NUM_PERMISSIONS; bit++) {
+            //Bit 8 (S_IRUSR) is the first character and bit 0 (S_IXOTH) the last
+            permTable[mode][bit] = (mode & (1 << (NUM_PERMISSIONS - 1 - bit))) ? letters[bit] : '-';
+        }
+    }
+}
+
+/**
+Writes a complete row in the format of ls -n (meta data, name and newline)
+directly into the output buffer. Permissions come from a lookup table, integers
+are converted two digits at a time and month strings are precomputed, so no
+intermediate strings are built.
+@meta_data - meta data of file to print
+@name - name of file to print
+**/
+void formatRow(struct stat* meta_data, char* name) {
+    int nameLen = myStrLen(name);
+
+    //Makes sure the whole row fits in the output buffer
+    if (outLen + MAX_ROW_LENGTH + nameLen + 1 > OUT_BUF_SIZE) flushOutput();
+    if (MAX_ROW_LENGTH + nameLen + 1 > OUT_BUF_SIZE) return;
+
+    char* p = outBuf + outLen;
+
+    //Inode number if selected
+    if (options.inode) {
+        p = formatUlong(p, meta_data->st_ino);
+        *p++ = ' ';
+    }
+
+    //Directory character and permissions
+    *p++ = "-d"[S_ISDIR(meta_data->st_mode) != 0];
+    myMemCpy(p, permTable[meta_data->st_mode & PERM_MASK], NUM_PERMISSIONS);
+    p += NUM_PERMISSIONS;
+
+    //Number of hard links, user id, group id and size
+    *p++ = ' ';
+    p = formatUlong(p, meta_data->st_nlink);
+    *p++ = ' ';
+    p = formatUlong(p, meta_data->st_uid);
+    *p++ = ' ';
+    p = formatUlong(p, meta_data->st_gid);
+    *p++ = ' ';
+    p = formatUlong(p, meta_data->st_size);
+    *p++ = ' ';
+
+    //Month and day of last modification
+    struct tm fileTime;
+    cachedLocaltime(meta_data->st_mtime, &fileTime);
+    myMemCpy(p, MONTH_SPACE_STRING[fileTime.tm_mon], MONTH_LENGTH + 1);
+    p += MONTH_LENGTH + 1;
+    p = formatUlong(p, fileTime.tm_mday);
+    *p++ = ' ';
+
+    //Time of modification if it is in the current year, otherwise the year
+    if (fileTime.tm_year + STARTING_YEAR == timeCache.currentYear) {
+        p[0] = DIGIT_PAIRS[fileTime.tm_hour * 2];
+        p[1] = DIGIT_PAIRS[fileTime.tm_hour * 2 + 1];
+        p[2] = ':';
+        p[3] = DIGIT_PAIRS[fileTime.tm_min * 2];
+        p[4] = DIGIT_PAIRS[fileTime.tm_min * 2 + 1];
+        p += 5;
+    } else {
+        p = formatUlong(p, fileTime.tm_year + STARTING_YEAR);
+    }
+
+    //Name of file
+    *p++ = ' ';
+    myMemCpy(p, name, nameLen);
+    p += nameLen;
+    *p++ = '\n';
+
+    outLen = p - outBuf;
+}
+
+/**
+Writes the decimal digits of a 64-bit integer to dest. The number of digits is
+counted first so digits can be written straight to their final position, two
+at a time using the digit pair table. No '\0' is appended.
+@dest - buffer to write digits to, at least MAX_LONG_DIGITS long
+@num - integer to convert
+@return - pointer to the byte after the last digit written
+**/
+char* formatUlong(char* dest, unsigned long num) {
+    int numDigits = countDigits(num);
+    char* p = dest + numDigits;
+
+    //Fills digits from the end, two at a time
+    while (num >= 100) {
+        unsigned long pair = (num % 100) * 2;
+        num /= 100;
+        *--p = DIGIT_PAIRS[pair + 1];
+        *--p = DIGIT_PAIRS[pair];
+    }
+
+    //Writes the first one or two digits
+    if (num >= 10) {
+        *--p = DIGIT_PAIRS[num * 2 + 1];
+        *--p = DIGIT_PAIRS[num * 2];
+    } else {
+        *--p = num + ASCII_CONVERSION_INT;
+    }
+
+    return dest + numDigits;
+}
+
+/**
+Counts the decimal digits of a 64-bit integer using the table of powers of 10
+@num - integer to count the digits of
+@return - number of digits, 1 for 0
+**/
+int countDigits(unsigned long num) {
+    int numDigits = 1;
+    while (numDigits < MAX_LONG_DIGITS && num >= POWERS_OF_10[numDigits - 1]) numDigits++;
+    return numDigits;
+}
+
+/**
+Formats the meta data of the current directory BENCH_ROWS times with
+printMetaData and then with formatRow, discarding the output, and prints the
+rows per second of each formatter. Then converts BENCH_ROWS integers with
+myitoa and with formatUlong and prints the integers per second of each.
+**/
+void runBenchmark() {
+    struct stat meta_data;
+    struct timespec start;
+    struct timespec end;
+    char numStr[MAX_INT_DIGITS + 1];
+
+    if (getMetaData(AT_FDCWD, ".", &meta_data) != 0) return;
+
+    for (int formatter = 0; formatter < 2; formatter++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_ROWS; i++) {
+            if (formatter == 0) {
+                printMetaData(meta_data);
+                myPrint(" ");
+                myPrint("bench");
+                myPrint("\n");
+            } else {
+                formatRow(&meta_data, "bench");
+            }
+            //Discards the row so that only formatting is measured
+            outLen = 0;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        long nsecs = (end.tv_sec - start.tv_sec) * NSECS_PER_SEC + (end.tv_nsec - start.tv_nsec);
+        myitoa((unsigned long) BENCH_ROWS * NSECS_PER_SEC / (nsecs > 0 ? nsecs : 1), numStr);
+        myPrint(formatter == 0 ? "printMetaData: " : "formatRow: ");
+        myPrint(numStr);
+        myPrint(" rows/second\n");
+        flushOutput();
+    }
+
+    //Converts 32-bit integers with myitoa and 64-bit sizes with formatUlong
+    char intStr[MAX_LONG_DIGITS + 1];
+    for (int converter = 0; converter < 2; converter++) {
+        //Volatile so the conversions it is summed from are not optimised away
+        volatile unsigned long checksum = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (unsigned int i = 0; i < BENCH_ROWS; i++) {
+            if (converter == 0) {
+                myitoa(i * 4099, intStr);
+            } else {
+                *formatUlong(intStr, i * 4099UL) = '\0';
+            }
+            checksum += intStr[0];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        long nsecs = (end.tv_sec - start.tv_sec) * NSECS_PER_SEC + (end.tv_nsec - start.tv_nsec);
+        myitoa((unsigned long) BENCH_ROWS * NSECS_PER_SEC / (nsecs > 0 ? nsecs : 1), numStr);
+        myPrint(converter == 0 ? "myitoa: " : "formatUlong: ");
+        myPrint(numStr);
+        myPrint(" integers/second\n");
+        flushOutput();
+    }
+}
+
+/**
+Prints meta data of files in directory by making repeated calls to printMetaData
+for each file name returned by myGetDents. getdents is called until it returns 0
+so that directories of any size are listed in full. The meta data of each batch
+of entries returned by getdents is fetched together by the selected engine
+before the batch is printed in the order it was read.
+@dirName - name of directory to print meta data of files
+**/
+void printDirEntries(char* dirName) {
+    //Struct to store directory entries returned by myGetDents
+    struct linux_dirent64 *d;
+
+    /*Buffer to store raw data returned by myGetDents. Mapped rather than on the
+    stack so that it can be large enough to read many entries per call*/
+    unsigned long bufSize = options.direntBufSize;
+    char* buf = myMmap(NULL, bufSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        writeErrorMsg(dirName, -ENOMEM);
+        return;
+    }
+
+    //Array of entries in the current batch, large enough for a full buffer of names
+    unsigned long entriesSize = (bufSize / MIN_DIRENT64_RECLEN) * sizeof(struct dirEntry);
+    struct dirEntry* entries = myMmap(NULL, entriesSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (entries == MAP_FAILED) {
+        myMunmap(buf, bufSize);
+        writeErrorMsg(dirName, -ENOMEM);
+        return;
+    }
+
+    /*Sets up io_uring or the thread pool if selected, falling back to
+    sequential stats if unavailable*/
+    struct uringQueue ring;
+    struct statPool pool;
+    int engine = options.engine;
+    if (engine == ENGINE_URING && uringInit(&ring, URING_QUEUE_DEPTH) != 0) engine = ENGINE_SEQUENTIAL;
+    if (engine == ENGINE_THREADS && poolInit(&pool, options.numThreads) != 0) engine = ENGINE_SEQUENTIAL;
+
+    //Opens directory for reading
+    int fd = myOpen(dirName, O_RDONLY);
+
+    //If directory opened successfully:
+    if (fd >= 0) {
+        int bytesRead;
+
+        //Reads directory entries until myGetDents reports the end of the directory
+        while ((bytesRead = myGetDents(fd, buf, bufSize)) != 0) {
+            /*If the buffer is too small for the next entry, doubles its size and
+            the size of the entry array and retries*/
+            if (bytesRead == -EINVAL && bufSize <= (unsigned long) MAX_DIRENT_BUF_KIB * KIB / 2) {
+                myMunmap(buf, bufSize);
+                myMunmap(entries, entriesSize);
+                bufSize *= 2;
+                entriesSize *= 2;
+                buf = myMmap(NULL, bufSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                entries = myMmap(NULL, entriesSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (buf == MAP_FAILED || entries == MAP_FAILED) {
+                    writeErrorMsg(dirName, -ENOMEM);
+                    break;
+                }
+                continue;
+            }
+
+            //Stops on any other error, reporting it as the listing is incomplete
+            if (bytesRead < 0) {
+                writeErrorMsg(dirName, bytesRead);
+                break;
+            }
+
+            //Adapted man 2 getdents code to produce following:
+
+            /*Iterates through directory entries in buffer and stops when the
+            number of bytes read is reached, recording each entry in the batch*/
+            int numEntries = 0;
+            for (int bpos = 0; bpos < bytesRead; bpos += d->d_reclen) {
+                //Gets current directory entry
+                d = (struct linux_dirent64 *) (buf + bpos);
+                stats.entries++;
+
+                struct dirEntry* entry = &entries[numEntries++];
+                entry->name = d->d_name;
+                entry->type = d->d_type;
+                entry->status = 0;
+                //If only names are listed and the type is known, stat is not needed
+                entry->needsStat = !(options.namesOnly && d->d_type != DT_UNKNOWN);
+            }
+
+            //Gets meta data of every entry in the batch
+            if (engine == ENGINE_URING) {
+                if (statBatchUring(&ring, fd, entries, numEntries) != 0) {
+                    uringExit(&ring);
+                    engine = ENGINE_SEQUENTIAL;
+                    statBatchSequential(fd, entries, numEntries);
+                }
+            } else if (engine == ENGINE_THREADS) {
+                statBatchPool(&pool, fd, entries, numEntries);
+            } else {
+                statBatchSequential(fd, entries, numEntries);
+            }
+
+            /*Prints entries in the order they were read. If getting meta data
+            failed the entry is skipped*/
+            for (int i = 0; i < numEntries; i++) {
+                struct dirEntry* entry = &entries[i];
+                if (entry->status != 0) continue;
+
+                if (options.namesOnly) {
+                    char dir[2];
+                    if (entry->needsStat) {
+                        getDirChar(entry->meta_data, dir);
+                    } else {
+                        getDirCharFromType(entry->type, dir);
+                    }
+                    printName(dir, entry->name);
+                } else {
+                    formatRow(&entry->meta_data, entry->name);
+                }
+            }
+        }
+        myClose(fd);
+    } else {
+        writeErrorMsg(dirName, fd);
+    }
+
+    if (engine == ENGINE_URING) uringExit(&ring);
+    if (engine == ENGINE_THREADS) poolExit(&pool);
+    if (entries != MAP_FAILED) myMunmap(entries, entriesSize);
+    if (buf != MAP_FAILED) myMunmap(buf, bufSize);
+}
+
+/**
+Gets meta data of a batch of directory entries with one stat call per entry
+@dirfd - file descriptor of directory containing entries
+@entries - entries to get meta data of
+@numEntries - number of entries in batch
+**/
+void statBatchSequential(long dirfd, struct dirEntry* entries, int numEntries) {
+    for (int i = 0; i < numEntries; i++) {
+        if (entries[i].needsStat) {
+            entries[i].status = getMetaData(dirfd, entries[i].name, &entries[i].meta_data);
+        }
+    }
+}
+
+/**
+Gets meta data of a batch of directory entries by queueing an IORING_OP_STATX
+request for each entry and reaping the completions. As many requests as fit in
+the submission queue are submitted with each io_uring_enter call, so a batch
+costs a handful of system calls rather than one per entry. Requests the kernel
+does not take are submitted again with the next call. If io_uring_enter fails
+the requests in flight are waited for before returning, so that the ring can
+be closed and the entries reused.
+@ring - io_uring set up by uringInit
+@dirfd - file descriptor of directory containing entries
+@entries - entries to get meta data of
+@numEntries - number of entries in batch
+@return - 0 if successful, negative error number if io_uring_enter failed
+**/
+int statBatchUring(struct uringQueue* ring, long dirfd, struct dirEntry* entries, int numEntries) {
+    int flags = options.dontSync ? AT_STATX_DONT_SYNC : AT_STATX_SYNC_AS_STAT;
+    unsigned int mask = statxMask();
+    int next = 0;
+    int inFlight = 0;
+    unsigned int queued = 0;
+
+    //Skips entries that do not need meta data
+    while (next < numEntries && !entries[next].needsStat) next++;
+
+    while (next < numEntries || inFlight > 0 || queued > 0) {
+        /*Queues requests until the submission queue is full or the batch is
+        done, after any the kernel has not yet taken*/
+        unsigned int tail = *ring->sqTail;
+        unsigned int toSubmit = queued;
+        while (next < numEntries && inFlight + toSubmit < ring->sqEntries) {
+            unsigned int index = tail & *ring->sqMask;
+            struct io_uring_sqe* sqe = &ring->sqes[index];
+
+            //Zeroes the entry before filling it in
+            char* sqeBytes = (char*) sqe;
+            for (unsigned int j = 0; j < sizeof(*sqe); j++) sqeBytes[j] = 0;
+
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirfd;
+            sqe->addr = (unsigned long) entries[next].name;
+            sqe->len = mask;
+            sqe->off = (unsigned long) &entries[next].stx;
+            sqe->statx_flags = flags;
+            sqe->user_data = next;
+            ring->sqArray[index] = index;
+
+            tail++;
+            toSubmit++;
+            do next++; while (next < numEntries && !entries[next].needsStat);
+        }
+
+        //Makes the new entries visible to the kernel before submitting them
+        __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+
+        /*Submits the new requests and waits for every request in flight so that
+        the queue is empty before it is refilled. If the kernel takes fewer
+        requests than were queued it returns without waiting, leaving the rest
+        in the queue to be submitted next time*/
+        int ret = myIoUringEnter(ring->fd, toSubmit, inFlight + toSubmit, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && ret != -EINTR) {
+            uringDrain(ring, inFlight);
+            return ret;
+        }
+        if (ret < 0) ret = 0;
+        inFlight += ret;
+        queued = toSubmit - ret;
+
+        //Reaps every completion that is available
+        unsigned int head = *ring->cqHead;
+        while (head != __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+            struct dirEntry* entry = &entries[cqe->user_data];
+
+            entry->status = cqe->res;
+            //Copies the statx result out first, as meta_data shares its memory
+            if (cqe->res == 0) {
+                struct statx stx = entry->stx;
+                statxToStat(&stx, &entry->meta_data);
+            }
+
+            head++;
+            inFlight--;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    return 0;
+}
+
+/**
+Starts a pool of worker threads that wait for batches of entries to stat
+@pool - pool to start
+@numThreads - number of worker threads
+@return - 0 if successful, error number if a thread could not be created
 **/
-int myStrLen(char* str) {
-    if (str == NULL) return -1;
+int poolInit(struct statPool* pool, int numThreads) {
+    pool->numThreads = 0;
+    pool->entries = NULL;
+    pool->numEntries = 0;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->batch = 0;
+    pool->shutdown = false;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+
+    for (int i = 0; i < numThreads; i++) {
+        int status = pthread_create(&pool->threads[i], NULL, poolWorker, pool);
+        if (status != 0) {
+            poolExit(pool);
+            return status;
+        }
+        pool->numThreads++;
+    }
 
-    int i;
-    for (i = 0; str[i] != '\0'; i++);
-    return i;
+    return 0;
 }
 
 /**
-Custom implementation of strcpy function
-@dest - destination to copy string to
-@src - source to copy string from
-@n - size of string to copy in bytes
+Stops the workers of a pool and waits for them to exit
+@pool - pool started by poolInit
 **/
-void myStrCpy(char* dest, const char* src, size_t n) {
-    //If src is NULL then operation is terminated.
-    if (src == NULL) {
-        return;
-    }
+void poolExit(struct statPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
 
-    size_t i;
-    for (i = 0; i < n; i++) {
-        dest[i] = src[i];
-    }
-    dest[i] = '\0';
+    for (int i = 0; i < pool->numThreads; i++) pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_mutex_destroy(&pool->lock);
 }
 
 /**
-Compares two strings for equality - used for unit testing
-@str1 - first string
-@str2 - second string
-return - whether string is equal
+Gets meta data of a batch of directory entries using the pool's workers, and
+returns once every entry has been stat'd
+@pool - pool started by poolInit
+@dirfd - file descriptor of directory containing entries
+@entries - entries to get meta data of
+@numEntries - number of entries in batch
 **/
-bool strEqual(char* str1, char* str2) {
-    if (str1 == NULL || str2 == NULL) return (str1 == str2);
+void statBatchPool(struct statPool* pool, long dirfd, struct dirEntry* entries, int numEntries) {
+    pthread_mutex_lock(&pool->lock);
+    pool->dirfd = dirfd;
+    pool->entries = entries;
+    pool->numEntries = numEntries;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->batch++;
+    pthread_cond_broadcast(&pool->workReady);
 
-    if (myStrLen(str1) != myStrLen(str2)) return false;
+    while (pool->finished < pool->numThreads) pthread_cond_wait(&pool->workDone, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
 
-    for (int i = 0; str1[i] != '\0'; i++) {
-        if (str1[i] != str2[i]) return false;
+/**
+Worker thread of a stat pool. Waits for a batch to be published, then stats
+entries from the shared counter until none are left
+@arg - pool the worker belongs to
+@return - NULL
+**/
+void* poolWorker(void* arg) {
+    struct statPool* pool = arg;
+    unsigned long seenBatch = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->shutdown && pool->batch == seenBatch) pthread_cond_wait(&pool->workReady, &pool->lock);
+        if (pool->shutdown) break;
+        seenBatch = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+
+        //Takes entries until the batch is exhausted
+        int i;
+        while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->numEntries) {
+            struct dirEntry* entry = &pool->entries[i];
+            if (entry->needsStat) entry->status = getMetaData(pool->dirfd, entry->name, &entry->meta_data);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->finished == pool->numThreads) pthread_cond_signal(&pool->workDone);
     }
+    pthread_mutex_unlock(&pool->lock);
 
-    return true;
+    return NULL;
 }
 
 /**
-Custom implementation of itoa function
-@num - positive integer to convert to string
-@str - char* to store converted string
+Sets up an io_uring and maps its submission and completion queues. Checks that
+the kernel supports IORING_OP_STATX so that callers can fall back otherwise.
+@ring - struct to store queue pointers in
+@entries - number of entries in the submission queue
+@return - 0 if successful, negative error number otherwise
 **/
-void myitoa(unsigned int num, char* str) {
-    char intStr[MAX_INT_DIGITS + 1];
-    int i = 0;
-
-    //Assigns 0 string if num is zero
-    if (num == 0) {
-        str[0] = '0';
-        str[1] = '\0';
-        return;
+int uringInit(struct uringQueue* ring, unsigned int entries) {
+    struct io_uring_params params;
+    char* paramBytes = (char*) &params;
+    for (unsigned int i = 0; i < sizeof(params); i++) paramBytes[i] = 0;
+
+    ring->fd = myIoUringSetup(entries, &params);
+    if (ring->fd < 0) return ring->fd;
+
+    //Checks the kernel supports statx requests
+    struct {
+        struct io_uring_probe probe;
+        struct io_uring_probe_op ops[IORING_OP_LAST];
+    } probe;
+    char* probeBytes = (char*) &probe;
+    for (unsigned int i = 0; i < sizeof(probe); i++) probeBytes[i] = 0;
+
+    int status = myIoUringRegister(ring->fd, IORING_REGISTER_PROBE, &probe, IORING_OP_LAST);
+    if (status != 0 || probe.probe.last_op < IORING_OP_STATX
+            || !(probe.ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED)) {
+        myClose(ring->fd);
+        return -EOPNOTSUPP;
     }
 
-    //Gets digits from least to most significant (reverse order in array)
-    while (num) {
-        //Gets least significant bit
-        intStr[i++] = num % 10;
-        //Reduces size of num by factor of 10
-        num /= 10;
+    //Maps the submission queue ring, completion queue ring and submission queue entries
+    ring->sqEntries = params.sq_entries;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sqRing = myMmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cqRing = myMmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = myMmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        if (ring->sqRing != MAP_FAILED) myMunmap(ring->sqRing, ring->sqRingSize);
+        if (ring->cqRing != MAP_FAILED) myMunmap(ring->cqRing, ring->cqRingSize);
+        if (ring->sqes != MAP_FAILED) myMunmap(ring->sqes, ring->sqesSize);
+        myClose(ring->fd);
+        return -ENOMEM;
     }
-    intStr[i] = '\0';
 
-    //Converts digits to ASCII and reorders in new array
-    for (int j = 0, k = i - 1; j < i; j++, k--) {
-        str[k] = intStr[j] + ASCII_CONVERSION_INT;
-    }
+    char* sq = ring->sqRing;
+    char* cq = ring->cqRing;
+    ring->sqHead = (unsigned int*) (sq + params.sq_off.head);
+    ring->sqTail = (unsigned int*) (sq + params.sq_off.tail);
+    ring->sqMask = (unsigned int*) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned int*) (sq + params.sq_off.array);
+    ring->cqHead = (unsigned int*) (cq + params.cq_off.head);
+    ring->cqTail = (unsigned int*) (cq + params.cq_off.tail);
+    ring->cqMask = (unsigned int*) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
 
-    str[i] = '\0';
+    return 0;
 }
 
 /**
-Prints meta data of file in the format of ls -n
-@meta_data - meta data of file to print
+Unmaps the queues of an io_uring and closes it
+@ring - io_uring set up by uringInit
 **/
-void printMetaData(struct stat meta_data) {
-    char tempStr[BUF_SIZE];
-
-    /* Gets the permissions and directory character of file and prints it using
-    myWrite*/
-    getDirChar(meta_data, tempStr);
-    myWrite(tempStr);
-    getFilePerm(meta_data, tempStr);
-    myWrite(tempStr);
-
-    /*Gets number of hard links, user id, group id, and size, converts all values
-    to strings, and then prints using myWrite*/
-    myWrite(" ");
-    myitoa(meta_data.st_nlink, tempStr);
-    myWrite(tempStr);
-    myWrite(" ");
-    myitoa(meta_data.st_uid, tempStr);
-    myWrite(tempStr);
-    myWrite(" ");
-    myitoa(meta_data.st_gid, tempStr);
-    myWrite(tempStr);
-    myWrite(" ");
-    myitoa(meta_data.st_size, tempStr);
-    myWrite(tempStr);
-    myWrite(" ");
-
-    //Prints the time the file was last modified
-    printModifiedTime(meta_data);
+void uringExit(struct uringQueue* ring) {
+    myMunmap(ring->sqRing, ring->sqRingSize);
+    myMunmap(ring->cqRing, ring->cqRingSize);
+    myMunmap(ring->sqes, ring->sqesSize);
+    myClose(ring->fd);
 }
 
 /**
-Prints meta data of files in directory by making repeated calls to printMetaData
-for each file name returned by myGetDents
-@dirName - name of directory to print meta data of files
+Waits for requests submitted to an io_uring to complete, discarding their
+results. Closing the ring does not wait for them, so the kernel could
+otherwise still write their results into memory that has been reused.
+@ring - io_uring set up by uringInit
+@inFlight - number of requests submitted but not yet reaped
 **/
-void printDirEntries(char* dirName) {
-    //Struct to store file meta data
-    struct stat meta_data;
-    //Struct to store directory entries returned by myGetDents
-    struct linux_dirent *d;
-    //Buffer to store raw data returned by myGetDents
-    char buf[BUF_SIZE];
+void uringDrain(struct uringQueue* ring, int inFlight) {
+    while (inFlight > 0) {
+        int ret = myIoUringEnter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && ret != -EINTR) return;
+
+        unsigned int head = *ring->cqHead;
+        while (head != __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+            head++;
+            inFlight--;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+}
 
-    //Opens directory for reading
-    int fd = myOpen(dirName, O_RDONLY);
+/**
+Gets the meta data printed by ls -n. statx is used to request only those fields,
+and with --dont-sync to allow cached attributes on network filesystems. If the
+kernel does not support statx then fstatat is used instead.
+@dirfd - file descriptor of directory fileName is relative to, or AT_FDCWD
+@fileName - name of file to get meta data about
+@meta_data - struct to store file meta data in
+@return - status code
+**/
+int getMetaData(long dirfd, char* fileName, struct stat* meta_data) {
+    if (!__atomic_load_n(&statxUnsupported, __ATOMIC_RELAXED)) {
+        struct statx stx;
+        int flags = options.dontSync ? AT_STATX_DONT_SYNC : AT_STATX_SYNC_AS_STAT;
+        int status = myStatx(dirfd, fileName, flags, statxMask(), &stx);
+
+        if (status != -ENOSYS) {
+            if (status == 0) statxToStat(&stx, meta_data);
+            return status;
+        }
 
-    //If directory opened successfully:
-    if (fd != -1) {
-        //Makes call to myGetDents
-        int bytesRead = myGetDents(fd, buf, BUF_SIZE);
+        __atomic_store_n(&statxUnsupported, true, __ATOMIC_RELAXED);
+    }
 
-        //If data has been read successfully:
-        if (bytesRead > 0) {
+    return myFstatAt(dirfd, fileName, meta_data, 0);
+}
 
-            //Adapted man 2 getdents code to produce following:
+/**
+Gets the fields to request from statx: those printed by ls -n, and the inode
+number if -i is given
+@return - mask of STATX_* flags
+**/
+unsigned int statxMask() {
+    return options.inode ? (STATX_LS_MASK | STATX_INO) : STATX_LS_MASK;
+}
 
-            /*Iterates through directory entries in buffer and stops when the
-            number of bytes read is reached */
-            for (int bpos = 0; bpos < bytesRead; bpos += d->d_reclen) {
-                //Gets current directory entry
-                d = (struct linux_dirent *) (buf + bpos);
-
-                /* Creates buffer to store name of current directory entry,
-                then appends name of directory at beginning, as well as '/', and
-                finally the file name. */
-                char name[BUF_SIZE];
-                myStrCpy(name, dirName, myStrLen(dirName));
-                myStrCpy(name + myStrLen(dirName), "/", myStrLen("/"));
-                myStrCpy(name + myStrLen(dirName) + myStrLen("/"), d->d_name, myStrLen(d->d_name));
-
-                //Calls myStat on current file to get meta data
-                int status = myStat(name, &meta_data);
-
-                /*If myStat returned successfully then the meta data is printed
-                along with the file name*/
-                if (!status) {
-                    printMetaData(meta_data);
-                    myWrite(" ");
-                    myWrite(d->d_name);
-                    myWrite("\n");
-                }
+/**
+Copies the fields returned by statx into a stat struct so that they can be
+printed by printMetaData
+@stx - meta data returned by statx
+@meta_data - struct to copy meta data into
+**/
+void statxToStat(struct statx* stx, struct stat* meta_data) {
+    meta_data->st_ino = stx->stx_ino;
+    meta_data->st_mode = stx->stx_mode;
+    meta_data->st_nlink = stx->stx_nlink;
+    meta_data->st_uid = stx->stx_uid;
+    meta_data->st_gid = stx->stx_gid;
+    meta_data->st_size = stx->stx_size;
+    meta_data->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    meta_data->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+}
 
+/**
+Prints type character and name of a file on one line, used when only names are listed
+@dir - character signifying whether the file is a directory or not
+@name - name of file
+**/
+void printName(char* dir, char* name) {
+    myPrint(dir);
+    myPrint(" ");
+    myPrint(name);
+    myPrint("\n");
+}
 
-            }
-        }
-        myClose(fd);
-    }
+/**
+Prints counters gathered while listing to stderr. The counters are 64-bit, so
+they are converted with formatUlong rather than myitoa
+**/
+void printStats() {
+    char numStr[MAX_LONG_DIGITS];
+
+    myWriteFd(STDERR, "myls: getdents calls: ", myStrLen("myls: getdents calls: "));
+    myWriteFd(STDERR, numStr, formatUlong(numStr, stats.getdentsCalls) - numStr);
+    myWriteFd(STDERR, "\nmyls: entries read: ", myStrLen("\nmyls: entries read: "));
+    myWriteFd(STDERR, numStr, formatUlong(numStr, stats.entries) - numStr);
+    myWriteFd(STDERR, "\nmyls: stat calls: ", myStrLen("\nmyls: stat calls: "));
+    myWriteFd(STDERR, numStr, formatUlong(numStr, stats.statCalls) - numStr);
+    myWriteFd(STDERR, "\nmyls: write calls: ", myStrLen("\nmyls: write calls: "));
+    myWriteFd(STDERR, numStr, formatUlong(numStr, stats.writeCalls) - numStr);
+    myWriteFd(STDERR, "\nmyls: io_uring_enter calls: ", myStrLen("\nmyls: io_uring_enter calls: "));
+    myWriteFd(STDERR, numStr, formatUlong(numStr, stats.uringEnterCalls) - numStr);
+    myWriteFd(STDERR, "\n", 1);
 }
 
 /**
- Prints error message similar to that printed by ls if file does not exist
-@fileName - name of file which does not exist
+ Prints error message similar to that printed by ls if file cannot be accessed
+@fileName - name of file which could not be accessed
+@err - negative error number returned by the failed system call
 **/
-void writeErrorMsg(char* fileName) {
+void writeErrorMsg(char* fileName, int err) {
+    char numStr[MAX_INT_DIGITS + 1];
+    char* message = errnoMessage(-err);
+
     //Assigns beginning of error message to buffer
     char error[BUF_SIZE] = "myls: cannot access '";
 
-    //Copies file name to error message buffer
+    //Copies file name to error message buffer, leaving room for the reason
     int size = myStrLen(error);
-    myStrCpy(error + size, fileName, myStrLen(fileName));
+    int nameLen = myStrLen(fileName);
+    if (nameLen > BUF_SIZE - size - 64) nameLen = BUF_SIZE - size - 64;
+    myStrCpy(error + size, fileName, nameLen);
 
-    //Appends end of error message to buffer
+    //Appends the reason, or the error number if it has no description
+    size = myStrLen(error);
+    myStrCpy(error + size, "': ", 3);
+    size += 3;
+    if (message != NULL) {
+        myStrCpy(error + size, message, myStrLen(message));
+    } else {
+        myitoa(-err, numStr);
+        myStrCpy(error + size, "error ", 6);
+        myStrCpy(error + size + 6, numStr, myStrLen(numStr));
+    }
     size = myStrLen(error);
-    myStrCpy(error + size, "': No such file or directory\n", myStrLen("': No such file or directory\n"));
+    myStrCpy(error + size, "\n", 1);
 
     //Prints error message using myWrite
-    myWrite(error);
+    myPrint(error);
+    failed = true;
+}
+
+/**
+Gets the description of an errno, as printed by strerror, for the errors that
+listing files can cause
+@err - positive errno
+@return - description, or NULL if it is not known
+**/
+char* errnoMessage(int err) {
+    switch (err) {
+        case ENOENT: return "No such file or directory";
+        case EIO: return "Input/output error";
+        case ENOMEM: return "Cannot allocate memory";
+        case EACCES: return "Permission denied";
+        case ENOTDIR: return "Not a directory";
+        case EINVAL: return "Invalid argument";
+        case ENFILE: return "Too many open files in system";
+        case EMFILE: return "Too many open files";
+        case ENAMETOOLONG: return "File name too long";
+        case ELOOP: return "Too many levels of symbolic links";
+        case EOVERFLOW: return "Value too large for defined data type";
+        case ESTALE: return "Stale file handle";
+        default: return NULL;
+    }
 }
 
 //Returns a particular character depending on whether a file is a directory or not.
@@ -618,6 +1993,17 @@ void getDirChar(struct stat meta_data, char* dir) {
     dir[1] = '\0';
 }
 
+/**
+Gets character signifying whether a file is a directory or not from the file
+type returned by getdents64, avoiding a call to stat
+@type - d_type of directory entry
+@dir - character array to store directory character
+**/
+void getDirCharFromType(unsigned char type, char* dir) {
+    dir[0] = (type == DT_DIR) ? 'd' : '-';
+    dir[1] = '\0';
+}
+
 //BEGIN CITATION: Learned how to use the masks from this page
 //-
 
@@ -648,39 +2034,31 @@ Prints last time file was modified
 @meta_data - meta data of file whose modified time is to be printed
 **/
 void printModifiedTime(struct stat meta_data) {
-    //Time structs to store file modification time and current time
-    struct tm* fileTime;
-    struct tm* currentTime;
+    //Time struct to store file modification time
+    struct tm fileTime;
 
-    //Integers to store current year and file year
-    int currentYear;
+    //Integer to store file year
     int fileYear;
 
     //Buffer to store time data
     char tempStr[MAX_INT_DIGITS];
 
-    //Gets the current time and year
-    time_t current;
-    current = myTime(NULL);
-    currentTime = localtime(&current);
-    currentYear = currentTime->tm_year + STARTING_YEAR;
-
     //Gets the time and year of the last modification to the file
-    fileTime = localtime(&meta_data.st_mtime);
-    fileYear = fileTime->tm_year + STARTING_YEAR;
+    cachedLocaltime(meta_data.st_mtime, &fileTime);
+    fileYear = fileTime.tm_year + STARTING_YEAR;
 
     //Converts month to a string and writes it using myWrite
-    monthToStr(fileTime->tm_mon, tempStr);
-    myWrite(tempStr);
-    myWrite(" ");
+    monthToStr(fileTime.tm_mon, tempStr);
+    myPrint(tempStr);
+    myPrint(" ");
 
     //Converts day to string and prints it using myWrite
-    myitoa(fileTime->tm_mday, tempStr);
-    myWrite(tempStr);
-    myWrite(" ");
+    myitoa(fileTime.tm_mday, tempStr);
+    myPrint(tempStr);
+    myPrint(" ");
 
     //If the modified year is the current year, prints the time of modification
-    if (fileYear == currentYear) {
+    if (fileYear == timeCache.currentYear) {
         //Sets initial hour value to 00
         tempStr[0] = '0';
         tempStr[1] = '0';
@@ -688,9 +2066,9 @@ void printModifiedTime(struct stat meta_data) {
 
         /*Formats hour depending on if hour is a single or double digit. Then
         prints hour of modification appended with a ':'*/
-        myitoa(fileTime->tm_hour, (fileTime->tm_hour > SINGLE_DIGIT ? tempStr : tempStr + 1));
-        myWrite(tempStr);
-        myWrite(":");
+        myitoa(fileTime.tm_hour, (fileTime.tm_hour > SINGLE_DIGIT ? tempStr : tempStr + 1));
+        myPrint(tempStr);
+        myPrint(":");
 
         //Sets initial minute value to 00
         tempStr[0] = '0';
@@ -698,15 +2076,70 @@ void printModifiedTime(struct stat meta_data) {
 
         /*Formats minutes depending on if minutes are single or double digit. Then
         prints minute of modification*/
-        myitoa(fileTime->tm_min, (fileTime->tm_min > SINGLE_DIGIT ? tempStr : tempStr + 1));
-        myWrite(tempStr);
+        myitoa(fileTime.tm_min, (fileTime.tm_min > SINGLE_DIGIT ? tempStr : tempStr + 1));
+        myPrint(tempStr);
 
     //Otherwise the year of modification is printed as in ls -n
     } else {
         myitoa(fileYear, tempStr);
-        myWrite(tempStr);
+        myPrint(tempStr);
+    }
+
+}
+
+/**
+Converts a time to local time like localtime_r, using the cached span where
+possible. The current year is computed on the first call. On a cache miss the
+span is set to the local day containing t, or to the hour containing t if the
+UTC offset changes during that day (e.g. daylight saving), so that the hour and
+minute of any time in the span are its offset from the start of the span.
+@t - time in seconds since Epoch
+@result - struct to store the local time in
+**/
+void cachedLocaltime(time_t t, struct tm* result) {
+    if (!timeCache.initialised) {
+        time_t current = myTime(NULL);
+        localtime_r(&current, result);
+        timeCache.currentYear = result->tm_year + STARTING_YEAR;
+        timeCache.start = 0;
+        timeCache.end = 0;
+        timeCache.initialised = true;
     }
 
+    //If time falls outside the cached span, calls localtime_r and caches the new span
+    if (t < timeCache.start || t >= timeCache.end) {
+        localtime_r(&t, result);
+
+        //Seconds since the start of the local day and of the local hour
+        long sinceHour = result->tm_min * SECS_PER_MIN + result->tm_sec;
+        long sinceDay = result->tm_hour * SECS_PER_HOUR + sinceHour;
+        struct tm startTime;
+        struct tm endTime;
+        time_t start = t - sinceDay;
+        time_t end = start + SECS_PER_DAY;
+        localtime_r(&start, &startTime);
+        localtime_r(&end, &endTime);
+
+        //If the UTC offset changes during the day, only caches the hour
+        if (startTime.tm_gmtoff != result->tm_gmtoff || endTime.tm_gmtoff != result->tm_gmtoff
+                || result->tm_sec >= SECS_PER_MIN) {
+            start = t - sinceHour;
+            end = start + SECS_PER_HOUR;
+            localtime_r(&start, &startTime);
+        }
+
+        timeCache.start = start;
+        timeCache.end = end;
+        timeCache.startTime = startTime;
+        return;
+    }
+
+    //Otherwise derives the local time from the offset into the cached span
+    long offset = t - timeCache.start;
+    *result = timeCache.startTime;
+    result->tm_hour += offset / SECS_PER_HOUR;
+    result->tm_min += (offset % SECS_PER_HOUR) / SECS_PER_MIN;
+    result->tm_sec += offset % SECS_PER_MIN;
 }
 
 /**
@@ -742,30 +2175,32 @@ int runTests(bool (*testFunctions[]) (), int numTests) {
     for (i = 0; i < numTests; i++) {
         if ((*testFunctions[i]) ()) {
             numPassingTests += 1;
-            myWrite(GREEN);
-            myWrite("\n***TEST ");
+            myPrint(GREEN);
+            myPrint("\n***TEST ");
             myitoa(i + 1, printBuf);
-            myWrite(printBuf);
-            myWrite(" PASSED***\n");
+            myPrint(printBuf);
+            myPrint(" PASSED***\n");
+            flushOutput();
         } else {
-            myWrite(RED);
-            myWrite("\n***TEST ");
+            myPrint(RED);
+            myPrint("\n***TEST ");
             myitoa(i + 1, printBuf);
-            myWrite(printBuf);
-            myWrite(" FAILED***\n");
+            myPrint(printBuf);
+            myPrint(" FAILED***\n");
+            flushOutput();
         }
     }
 
     //Displays total number of unit tests which have passed
-    myWrite("\n***");
+    myPrint("\n***");
     (numPassingTests > 0) ? myitoa(numPassingTests, printBuf) : myStrCpy(printBuf, "0", 1);
-    myWrite(printBuf);
-    myWrite("/");
+    myPrint(printBuf);
+    myPrint("/");
     myitoa(i, printBuf);
-    myWrite(printBuf);
-    myWrite(" TESTS PASSED***\n");
+    myPrint(printBuf);
+    myPrint(" TESTS PASSED***\n");
 
-    myWrite(WHITE);
+    myPrint(WHITE);
     return numPassingTests;
 }
 
@@ -817,6 +2252,40 @@ void initTests(bool (*testFunctions[]) ()) {
     testFunctions[40] = getFilePermTest1;
     testFunctions[41] = getDirCharTest1;
     testFunctions[42] = getDirCharTest2;
+    testFunctions[43] = myMmapTest1;
+    testFunctions[44] = myMmapTest2;
+    testFunctions[45] = myMunmapTest1;
+    testFunctions[46] = strPrefixTest1;
+    testFunctions[47] = strPrefixTest2;
+    testFunctions[48] = myatoiTest1;
+    testFunctions[49] = myatoiTest2;
+    testFunctions[50] = getDirCharFromTypeTest1;
+    testFunctions[51] = getDirCharFromTypeTest2;
+    testFunctions[52] = myGetDentsTest3;
+    testFunctions[53] = myPrintTest1;
+    testFunctions[54] = myPrintTest2;
+    testFunctions[55] = flushOutputTest1;
+    testFunctions[56] = myFstatAtTest1;
+    testFunctions[57] = myFstatAtTest2;
+    testFunctions[58] = myFstatAtTest3;
+    testFunctions[59] = myStatxTest1;
+    testFunctions[60] = myStatxTest2;
+    testFunctions[61] = getMetaDataTest1;
+    testFunctions[62] = statBatchSequentialTest1;
+    testFunctions[63] = statBatchUringTest1;
+    testFunctions[64] = statBatchPoolTest1;
+    testFunctions[65] = cachedLocaltimeTest1;
+    testFunctions[66] = cachedLocaltimeTest2;
+    testFunctions[67] = formatUlongTest1;
+    testFunctions[68] = formatUlongTest2;
+    testFunctions[69] = formatRowTest1;
+    testFunctions[70] = formatRowTest2;
+    testFunctions[71] = formatUlongTest3;
+    testFunctions[72] = countDigitsTest1;
+    testFunctions[73] = myltoaTest1;
+    testFunctions[74] = myltoaTest2;
+    testFunctions[75] = formatRowTest3;
+    testFunctions[76] = myatoiTest3;
 }
 
 //Tests that strEqual returns true if two strings are equal
@@ -1151,3 +2620,350 @@ bool getDirCharTest2() {
 
     return (strEqual(buf, "d"));
 }
+
+//Tests that an anonymous mapping can be created and written to
+bool myMmapTest1() {
+    char* buf = myMmap(NULL, DEFAULT_DIRENT_BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) return false;
+
+    buf[DEFAULT_DIRENT_BUF_SIZE - 1] = 'a';
+    bool written = (buf[DEFAULT_DIRENT_BUF_SIZE - 1] == 'a');
+    myMunmap(buf, DEFAULT_DIRENT_BUF_SIZE);
+    return written;
+}
+
+//Tests that MAP_FAILED is returned for a zero length mapping
+bool myMmapTest2() {
+    char* buf = myMmap(NULL, 0, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (buf == MAP_FAILED);
+}
+
+//Tests that a mapping can be removed successfully
+bool myMunmapTest1() {
+    char* buf = myMmap(NULL, DEFAULT_DIRENT_BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (myMunmap(buf, DEFAULT_DIRENT_BUF_SIZE) == 0);
+}
+
+//Tests that strPrefix finds a prefix of an option
+bool strPrefixTest1() {
+    return (strPrefix("--bufsize=64", "--bufsize="));
+}
+
+//Tests that strPrefix rejects a prefix longer than the string
+bool strPrefixTest2() {
+    return (!strPrefix("--buf", "--bufsize="));
+}
+
+//Tests that myatoi converts normal data to an integer
+bool myatoiTest1() {
+    return (myatoi("1024") == 1024);
+}
+
+//Tests that myatoi returns an error for a non-numeric string
+bool myatoiTest2() {
+    return (myatoi("64k") == -1);
+}
+
+//Tests that "d" is returned for a directory entry type
+bool getDirCharFromTypeTest1() {
+    char buf[2];
+    getDirCharFromType(DT_DIR, buf);
+    return (strEqual(buf, "d"));
+}
+
+//Tests that "-" is returned for a regular file entry type
+bool getDirCharFromTypeTest2() {
+    char buf[2];
+    getDirCharFromType(DT_REG, buf);
+    return (strEqual(buf, "-"));
+}
+
+//Tests that the first entry returned for the current directory has a known type
+bool myGetDentsTest3() {
+    int fd = myOpen(".", O_RDONLY);
+    char buf[BUF_SIZE];
+    int bytesRead = myGetDents(fd, buf, BUF_SIZE);
+    myClose(fd);
+    struct linux_dirent64* d = (struct linux_dirent64*) buf;
+    return (bytesRead > 0 && d->d_type != DT_UNKNOWN);
+}
+
+//Tests that myPrint gathers output in the buffer without writing it
+bool myPrintTest1() {
+    unsigned long writeCalls = stats.writeCalls;
+    myPrint("\nBuffered output\n");
+    bool buffered = ((int) outLen == myStrLen("\nBuffered output\n") && stats.writeCalls == writeCalls);
+    flushOutput();
+    return buffered;
+}
+
+//Tests that output larger than the buffer is written without overflowing it
+bool myPrintTest2() {
+    char* buf = myMmap(NULL, OUT_BUF_SIZE + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    //Fills buffer with spaces
+    for (int i = 0; i < OUT_BUF_SIZE + 1; i++) buf[i] = ' ';
+    myPrint("\n");
+    myPrintN(buf, OUT_BUF_SIZE + 1);
+    myMunmap(buf, OUT_BUF_SIZE + 1);
+    return (outLen == 0);
+}
+
+//Tests that flushing writes all buffered output in one write call
+bool flushOutputTest1() {
+    myPrint("\nFirst line\n");
+    myPrint("Second line\n");
+    unsigned long writeCalls = stats.writeCalls;
+    int status = flushOutput();
+    return (status == 0 && outLen == 0 && stats.writeCalls == writeCalls + 1);
+}
+
+//Tests that myFstatAt returns 0 for a valid file relative to an open directory
+bool myFstatAtTest1() {
+    struct stat meta_data;
+    int fd = myOpen(".", O_RDONLY);
+    int status = myFstatAt(fd, "myls.c", &meta_data, 0);
+    myClose(fd);
+    return (status == 0 && S_ISREG(meta_data.st_mode));
+}
+
+//Tests that myFstatAt returns an error number for a non-existent file
+bool myFstatAtTest2() {
+    struct stat meta_data;
+    int fd = myOpen(".", O_RDONLY);
+    int status = myFstatAt(fd, "Non-existent file", &meta_data, 0);
+    myClose(fd);
+    return (status != 0);
+}
+
+//Tests that myFstatAt resolves relative to the current directory with AT_FDCWD
+bool myFstatAtTest3() {
+    struct stat meta_data;
+    int status = myFstatAt(AT_FDCWD, "myls.c", &meta_data, 0);
+    return (status == 0);
+}
+
+//Tests that myStatx returns the requested fields for a valid file
+bool myStatxTest1() {
+    struct statx stx;
+    int status = myStatx(AT_FDCWD, "myls.c", AT_STATX_DONT_SYNC, STATX_LS_MASK, &stx);
+    return (status == 0 && (stx.stx_mask & STATX_SIZE) && S_ISREG(stx.stx_mode));
+}
+
+//Tests that myStatx returns an error number for a non-existent file
+bool myStatxTest2() {
+    struct statx stx;
+    int status = myStatx(AT_FDCWD, "Non-existent file", 0, STATX_LS_MASK, &stx);
+    return (status != 0);
+}
+
+//Tests that getMetaData returns the same size and mode as myStat
+bool getMetaDataTest1() {
+    struct stat expected;
+    struct stat meta_data;
+    myStat("myls.c", &expected);
+    int status = getMetaData(AT_FDCWD, "myls.c", &meta_data);
+    return (status == 0 && meta_data.st_size == expected.st_size
+            && meta_data.st_mode == expected.st_mode
+            && meta_data.st_mtime == expected.st_mtime);
+}
+
+//Tests that the sequential engine gets meta data of entries and reports missing files
+bool statBatchSequentialTest1() {
+    struct dirEntry entries[2];
+    entries[0].name = "myls.c";
+    entries[0].needsStat = true;
+    entries[1].name = "Non-existent file";
+    entries[1].needsStat = true;
+
+    statBatchSequential(AT_FDCWD, entries, 2);
+    return (entries[0].status == 0 && S_ISREG(entries[0].meta_data.st_mode) && entries[1].status != 0);
+}
+
+/*Tests that the io_uring engine gets the same meta data as the sequential engine.
+Passes if io_uring is unavailable, as the sequential engine is used instead*/
+bool statBatchUringTest1() {
+    struct uringQueue ring;
+    if (uringInit(&ring, URING_QUEUE_DEPTH) != 0) return true;
+
+    struct dirEntry entries[3];
+    entries[0].name = "myls.c";
+    entries[0].needsStat = true;
+    entries[1].name = "Makefile";
+    entries[1].needsStat = false;
+    entries[1].status = 0;
+    entries[2].name = "Non-existent file";
+    entries[2].needsStat = true;
+
+    struct stat expected;
+    myStat("myls.c", &expected);
+    int status = statBatchUring(&ring, AT_FDCWD, entries, 3);
+    uringExit(&ring);
+
+    return (status == 0 && entries[0].status == 0 && entries[0].meta_data.st_size == expected.st_size
+            && entries[1].status == 0 && entries[2].status != 0);
+}
+
+//Tests that the thread pool gets meta data of every entry in a batch, in order
+bool statBatchPoolTest1() {
+    struct statPool pool;
+    if (poolInit(&pool, 4) != 0) return false;
+
+    char* names[4] = { "myls.c", "Non-existent file", "Makefile", "README.md" };
+    struct dirEntry entries[4];
+    for (int i = 0; i < 4; i++) {
+        entries[i].name = names[i];
+        entries[i].needsStat = true;
+    }
+
+    //Runs two batches to check workers wake up for each one
+    statBatchPool(&pool, AT_FDCWD, entries, 2);
+    statBatchPool(&pool, AT_FDCWD, entries + 2, 2);
+    poolExit(&pool);
+
+    struct stat expected;
+    myStat("Makefile", &expected);
+    return (entries[0].status == 0 && entries[1].status != 0 && entries[2].status == 0
+            && entries[2].meta_data.st_size == expected.st_size && entries[3].status == 0);
+}
+
+//Tests that cachedLocaltime gives the same date and time as localtime_r across several days
+bool cachedLocaltimeTest1() {
+    time_t current = myTime(NULL);
+
+    //Checks times every 7 minutes 13 seconds over four days, hitting and missing the cache
+    for (time_t t = current - 2 * SECS_PER_DAY; t < current + 2 * SECS_PER_DAY; t += 433) {
+        struct tm expected;
+        struct tm result;
+        localtime_r(&t, &expected);
+        cachedLocaltime(t, &result);
+
+        if (result.tm_year != expected.tm_year || result.tm_mon != expected.tm_mon
+                || result.tm_mday != expected.tm_mday || result.tm_hour != expected.tm_hour
+                || result.tm_min != expected.tm_min) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Tests that the cached current year matches the year returned by localtime_r
+bool cachedLocaltimeTest2() {
+    time_t current = myTime(NULL);
+    struct tm expected;
+    struct tm result;
+    localtime_r(&current, &expected);
+    cachedLocaltime(current, &result);
+    return (timeCache.currentYear == expected.tm_year + STARTING_YEAR);
+}
+
+//Tests that formatUlong converts 0 and single digit numbers
+bool formatUlongTest1() {
+    char buf[MAX_INT_DIGITS + 1];
+    *formatUlong(buf, 0) = '\0';
+    bool zero = strEqual(buf, "0");
+    *formatUlong(buf, 7) = '\0';
+    return (zero && strEqual(buf, "7"));
+}
+
+//Tests that formatUlong converts numbers with odd and even numbers of digits
+bool formatUlongTest2() {
+    char buf[MAX_INT_DIGITS + 1];
+    *formatUlong(buf, 10) = '\0';
+    bool even = strEqual(buf, "10");
+    *formatUlong(buf, 4294967295U) = '\0';
+    return (even && strEqual(buf, "4294967295"));
+}
+
+/*Checks that formatRow produces the same row as printMetaData for a file.
+Rows are built in the output buffer and discarded*/
+bool formatRowMatches(char* fileName) {
+    char expected[BUF_SIZE];
+    struct stat meta_data;
+    if (myStat(fileName, &meta_data) != 0) return false;
+
+    flushOutput();
+    printMetaData(meta_data);
+    myPrint(" ");
+    myPrint(fileName);
+    myPrint("\n");
+    int expectedLen = outLen;
+    myMemCpy(expected, outBuf, outLen);
+    outLen = 0;
+
+    formatRow(&meta_data, fileName);
+    bool equal = ((int) outLen == expectedLen);
+    for (int i = 0; equal && i < expectedLen; i++) equal = (outBuf[i] == expected[i]);
+    outLen = 0;
+
+    return equal;
+}
+
+//Tests that formatRow matches printMetaData for a regular file
+bool formatRowTest1() {
+    return formatRowMatches("myls.c");
+}
+
+//Tests that formatRow matches printMetaData for a directory
+bool formatRowTest2() {
+    return formatRowMatches(".");
+}
+
+//Tests that formatUlong converts the largest 64-bit integer
+bool formatUlongTest3() {
+    char buf[MAX_LONG_DIGITS + 1];
+    *formatUlong(buf, 18446744073709551615UL) = '\0';
+    return (strEqual(buf, "18446744073709551615"));
+}
+
+//Tests that countDigits is correct either side of powers of 10
+bool countDigitsTest1() {
+    return (countDigits(0) == 1 && countDigits(9) == 1 && countDigits(10) == 2
+            && countDigits(99999) == 5 && countDigits(100000) == 6
+            && countDigits(9999999999999999999UL) == 19
+            && countDigits(10000000000000000000UL) == 20);
+}
+
+//Tests that myltoa does not truncate a size over 4 GiB
+bool myltoaTest1() {
+    char buf[MAX_LONG_DIGITS + 1];
+    myltoa(5368709120UL, buf);
+    return (strEqual(buf, "5368709120"));
+}
+
+//Tests that myltoa returns string representation of 0
+bool myltoaTest2() {
+    char buf[MAX_LONG_DIGITS + 1];
+    myltoa(0, buf);
+    return (strEqual(buf, "0"));
+}
+
+//Tests that a size over 4 GiB, set directly in the stat struct, is printed in full
+bool formatRowTest3() {
+    int fd = myCreat("Test.txt", 0644);
+    myClose(fd);
+    struct stat meta_data;
+    myStat("Test.txt", &meta_data);
+    myUnlink("Test.txt");
+
+    meta_data.st_size = 5368709120L;
+    flushOutput();
+    formatRow(&meta_data, "Test.txt");
+
+    //Finds the size after the fourth space in the row
+    int spaces = 0;
+    int i;
+    for (i = 0; i < (int) outLen && spaces < 4; i++) {
+        if (outBuf[i] == ' ') spaces++;
+    }
+    bool found = (i + 10 < (int) outLen);
+    for (int j = 0; found && j < 10; j++) found = (outBuf[i + j] == "5368709120"[j]);
+    outLen = 0;
+
+    return found;
+}
+
+//Tests that myatoi returns an error for a number too large for a long
+bool myatoiTest3() {
+    return (myatoi("9223372036854775807") == 9223372036854775807L && myatoi("9223372036854775808") == -1);
+}